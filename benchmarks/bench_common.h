@@ -0,0 +1,219 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <aogmaneo/helpers.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef AOGMANEO_GIT_TAG
+#define AOGMANEO_GIT_TAG "unknown"
+#endif
+
+namespace bench {
+struct Options {
+    int steps;
+    int warmup_steps;
+    bool quick;
+    std::string out_file_name;
+
+    Options()
+    :
+    steps(100),
+    warmup_steps(10),
+    quick(false)
+    {}
+};
+
+// --steps N, --warmup N, --quick (reduced matrix), --out file.json (default stdout)
+inline Options parse_options(
+    int argc,
+    char** argv
+) {
+    Options options;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--steps" && i + 1 < argc)
+            options.steps = std::max(1, std::atoi(argv[++i]));
+        else if (arg == "--warmup" && i + 1 < argc)
+            options.warmup_steps = std::max(0, std::atoi(argv[++i]));
+        else if (arg == "--quick")
+            options.quick = true;
+        else if (arg == "--out" && i + 1 < argc)
+            options.out_file_name = argv[++i];
+        else {
+            std::cerr << "usage: " << argv[0] << " [--steps N] [--warmup N] [--quick] [--out file.json]" << std::endl;
+
+            std::exit(1);
+        }
+    }
+
+    return options;
+}
+
+inline double now_us() {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// latency samples of one benchmark, in microseconds
+struct Stats {
+    double mean_us;
+    double p50_us;
+    double p99_us;
+    double min_us;
+    double per_second;
+
+    Stats(
+        std::vector<double> samples
+    ) {
+        std::sort(samples.begin(), samples.end());
+
+        double total = 0.0;
+
+        for (double s : samples)
+            total += s;
+
+        mean_us = total / samples.size();
+        p50_us = samples[samples.size() / 2];
+        p99_us = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+        min_us = samples[0];
+        per_second = 1000000.0 / std::max(1e-9, mean_us);
+    }
+};
+
+// runs f for the warmup steps, then times each of the remaining steps
+template<typename F>
+Stats measure(
+    const Options &options,
+    F f
+) {
+    for (int t = 0; t < options.warmup_steps; t++)
+        f(t);
+
+    std::vector<double> samples(options.steps);
+
+    for (int t = 0; t < options.steps; t++) {
+        double start = now_us();
+
+        f(t);
+
+        samples[t] = now_us() - start;
+    }
+
+    return Stats(samples);
+}
+
+inline std::string int3_to_json(
+    const aon::Int3 &v
+) {
+    return "[" + std::to_string(v.x) + ", " + std::to_string(v.y) + ", " + std::to_string(v.z) + "]";
+}
+
+inline std::string quote(
+    const std::string &s
+) {
+    return "\"" + s + "\"";
+}
+
+// collects flat result records and writes them as one JSON document
+class Json_Results {
+private:
+    std::string suite;
+    std::vector<std::string> records;
+
+public:
+    Json_Results(
+        const std::string &suite
+    )
+    :
+    suite(suite)
+    {}
+
+    // fields are (key, already JSON-encoded value) pairs
+    void add(
+        const std::vector<std::pair<std::string, std::string>> &fields,
+        const Stats &stats
+    ) {
+        std::ostringstream os;
+
+        os.precision(3);
+        os << std::fixed;
+
+        os << "    {";
+
+        for (const auto &field : fields)
+            os << quote(field.first) << ": " << field.second << ", ";
+
+        os << "\"mean_us\": " << stats.mean_us << ", \"p50_us\": " << stats.p50_us << ", \"p99_us\": " << stats.p99_us << ", \"min_us\": " << stats.min_us << ", \"per_second\": " << stats.per_second << "}";
+
+        records.push_back(os.str());
+
+        // progress on stderr so stdout stays valid JSON
+        std::cerr << records.back() << std::endl;
+    }
+
+    void write(
+        const Options &options
+    ) const {
+        std::ostringstream os;
+
+        os << "{\n";
+        os << "  \"suite\": " << quote(suite) << ",\n";
+        os << "  \"aogmaneo_git_tag\": " << quote(AOGMANEO_GIT_TAG) << ",\n";
+        os << "  \"steps\": " << options.steps << ",\n";
+        os << "  \"warmup_steps\": " << options.warmup_steps << ",\n";
+        os << "  \"results\": [\n";
+
+        for (size_t i = 0; i < records.size(); i++)
+            os << records[i] << (i + 1 < records.size() ? ",\n" : "\n");
+
+        os << "  ]\n";
+        os << "}\n";
+
+        if (options.out_file_name.empty())
+            std::cout << os.str();
+        else {
+            std::ofstream outs(options.out_file_name);
+
+            outs << os.str();
+        }
+    }
+};
+
+// thread counts to sweep, up to what OpenMP reports as available
+inline std::vector<int> thread_counts(
+    bool quick
+) {
+    int max_threads = aon::get_num_threads();
+
+    std::vector<int> counts;
+
+    for (int n = 1; n <= max_threads; n *= 2) {
+        counts.push_back(n);
+
+        if (quick && counts.size() == 2)
+            break;
+    }
+
+    if (!quick && counts.back() != max_threads)
+        counts.push_back(max_threads);
+
+    return counts;
+}
+}
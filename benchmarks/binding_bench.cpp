@@ -0,0 +1,212 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+// binding overhead of pyaon::Hierarchy::step and the getters, against the bare aon::Hierarchy::step
+// runs inside an embedded interpreter, since the binding code needs numpy
+// if the built pyaogmaneo module can be imported, the full Python call path is measured as well
+
+#include "bench_common.h"
+
+#include "py_hierarchy.h"
+
+#include <pybind11/embed.h>
+
+#ifndef PYAOGMANEO_MODULE_DIR
+#define PYAOGMANEO_MODULE_DIR ""
+#endif
+
+using namespace bench;
+
+namespace {
+void bench_hierarchy_bindings(
+    const Options &options,
+    Json_Results &results,
+    const py::object &neo
+) {
+    std::vector<int> layer_counts = { 1, 2 };
+    std::vector<aon::Int3> hidden_sizes = { aon::Int3(4, 4, 16), aon::Int3(8, 8, 32) };
+    std::vector<aon::Int3> io_sizes = { aon::Int3(4, 4, 16), aon::Int3(16, 16, 16) };
+
+    if (options.quick) {
+        layer_counts = { 2 };
+        hidden_sizes = { aon::Int3(8, 8, 32) };
+    }
+
+    // overhead is per call, so a single thread keeps the core step noise low
+    aon::set_num_threads(1);
+
+    for (int num_layers : layer_counts)
+        for (const aon::Int3 &hidden_size : hidden_sizes)
+            for (const aon::Int3 &io_size : io_sizes) {
+                int num_columns = io_size.x * io_size.y;
+
+                std::vector<std::pair<std::string, std::string>> fields = {
+                    { "num_layers", std::to_string(num_layers) },
+                    { "hidden_size", int3_to_json(hidden_size) },
+                    { "io_size", int3_to_json(io_size) },
+                    { "num_threads", "1" }
+                };
+
+                auto with_bench = [&](const std::string &name) {
+                    std::vector<std::pair<std::string, std::string>> f = fields;
+
+                    f.insert(f.begin(), std::make_pair(std::string("bench"), quote(name)));
+
+                    return f;
+                };
+
+                std::vector<pyaon::IO_Desc> io_descs = {
+                    pyaon::IO_Desc(std::make_tuple(io_size.x, io_size.y, io_size.z), pyaon::prediction, 4, 2, 2, 128, 4, 512)
+                };
+
+                std::vector<pyaon::Layer_Desc> layer_descs;
+
+                for (int l = 0; l < num_layers; l++)
+                    layer_descs.push_back(pyaon::Layer_Desc(std::make_tuple(hidden_size.x, hidden_size.y, hidden_size.z), 4, 2, 0, 2));
+
+                // core reference, same structure and seed
+                aon::global_state = 1234;
+
+                aon::Array<aon::Hierarchy::IO_Desc> c_io_descs(1);
+
+                c_io_descs[0] = aon::Hierarchy::IO_Desc(io_size, aon::prediction, 4, 2, 2, 128, 4, 512);
+
+                aon::Array<aon::Hierarchy::Layer_Desc> c_layer_descs(num_layers);
+
+                for (int l = 0; l < num_layers; l++)
+                    c_layer_descs[l] = aon::Hierarchy::Layer_Desc(hidden_size, 4, 2, 0, 2);
+
+                aon::Hierarchy c_h;
+
+                c_h.init_random(c_io_descs, c_layer_descs);
+
+                aon::Int_Buffer c_input(num_columns);
+                aon::Array<aon::Int_Buffer_View> c_inputs(1);
+
+                results.add(with_bench("core_step"), measure(options, [&](int t) {
+                    for (int j = 0; j < num_columns; j++)
+                        c_input[j] = (j + t) % io_size.z;
+
+                    c_inputs[0] = c_input;
+
+                    c_h.step(c_inputs, true, 0.0f, 0.0f);
+                }));
+
+                // binding layer called from C++, includes validation, input viewing and the GIL release
+                aon::global_state = 1234;
+
+                pyaon::Hierarchy h(io_descs, layer_descs, std::string(), py::bytes());
+
+                std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> inputs(1, py::array_t<int, py::array::c_style | py::array::forcecast>(num_columns));
+
+                int* input_data = inputs[0].mutable_data();
+
+                results.add(with_bench("binding_step"), measure(options, [&](int t) {
+                    for (int j = 0; j < num_columns; j++)
+                        input_data[j] = (j + t) % io_size.z;
+
+                    h.step(inputs, true, 0.0f, 0.0f, true);
+                }));
+
+                results.add(with_bench("binding_step_no_validate"), measure(options, [&](int t) {
+                    for (int j = 0; j < num_columns; j++)
+                        input_data[j] = (j + t) % io_size.z;
+
+                    h.step(inputs, true, 0.0f, 0.0f, false);
+                }));
+
+                results.add(with_bench("binding_get_prediction_cis_copy"), measure(options, [&](int t) {
+                    h.get_prediction_cis(0, true, py::none());
+                }));
+
+                py::array_t<int> out(num_columns);
+
+                results.add(with_bench("binding_get_prediction_cis_out"), measure(options, [&](int t) {
+                    h.get_prediction_cis(0, true, out);
+                }));
+
+                results.add(with_bench("binding_get_prediction_acts_copy"), measure(options, [&](int t) {
+                    h.get_prediction_acts(0, true, py::none());
+                }));
+
+                results.add(with_bench("binding_get_hidden_cis_copy"), measure(options, [&](int t) {
+                    h.get_hidden_cis(0, true, py::none());
+                }));
+
+                if (neo.is_none())
+                    continue;
+
+                // full Python call path, through the built module (which has its own copy of the global state)
+                neo.attr("set_global_state")(1234);
+                neo.attr("set_num_threads")(1);
+
+                py::list py_io_descs;
+
+                py_io_descs.append(neo.attr("IODesc")(py::make_tuple(io_size.x, io_size.y, io_size.z), neo.attr("prediction")));
+
+                py::list py_layer_descs;
+
+                for (int l = 0; l < num_layers; l++)
+                    py_layer_descs.append(neo.attr("LayerDesc")(py::make_tuple(hidden_size.x, hidden_size.y, hidden_size.z)));
+
+                py::object py_h = neo.attr("Hierarchy")(py_io_descs, py_layer_descs);
+
+                py::object py_step = py_h.attr("step");
+                py::object py_get_prediction_cis = py_h.attr("get_prediction_cis");
+
+                py::list py_inputs;
+
+                py_inputs.append(inputs[0]);
+
+                results.add(with_bench("python_step"), measure(options, [&](int t) {
+                    for (int j = 0; j < num_columns; j++)
+                        input_data[j] = (j + t) % io_size.z;
+
+                    py_step(py_inputs, true);
+                }));
+
+                results.add(with_bench("python_get_prediction_cis_copy"), measure(options, [&](int t) {
+                    py_get_prediction_cis(0);
+                }));
+
+                results.add(with_bench("python_get_prediction_cis_view"), measure(options, [&](int t) {
+                    py_get_prediction_cis(0, py::arg("copy") = false);
+                }));
+            }
+}
+}
+
+int main(
+    int argc,
+    char** argv
+) {
+    Options options = parse_options(argc, argv);
+
+    py::scoped_interpreter guard;
+
+    py::module_::import("numpy");
+
+    py::object neo = py::none();
+
+    try {
+        py::module_::import("sys").attr("path").attr("insert")(0, PYAOGMANEO_MODULE_DIR);
+
+        neo = py::module_::import("pyaogmaneo");
+    }
+    catch (const py::error_already_set &e) {
+        std::cerr << "pyaogmaneo not importable, skipping the Python call path: " << e.what() << std::endl;
+    }
+
+    Json_Results results("bindings");
+
+    bench_hierarchy_bindings(options, results, neo);
+
+    results.write(options);
+
+    return 0;
+}
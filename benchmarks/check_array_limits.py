@@ -0,0 +1,39 @@
+# -*- coding: utf-8 -*-
+
+# ----------------------------------------------------------------------------
+#  PyAOgmaNeo
+#  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+#
+#  This copy of PyAOgmaNeo is licensed to you under the terms described
+#  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+# ----------------------------------------------------------------------------
+
+# the constructor must reject a first layer encoder whose weights would not fit an int-indexed array,
+# before allocating anything, so this runs in little memory
+# exits non-zero on a mismatch, registered with CTest when benchmarks are built
+
+import pyaogmaneo as neo
+
+neo.set_num_threads(1)
+
+def fail(message):
+    print("FAIL: " + message)
+
+    raise SystemExit(1)
+
+# 64 * 64 * 64 hidden cells x 7 * 7 receptive area x 256 input cells = 3288334336 weights, past 2^31 - 1
+try:
+    neo.Hierarchy([ neo.IODesc((4, 4, 16)), neo.IODesc((8, 8, 256), up_radius=3) ], [ neo.LayerDesc(hidden_size=(64, 64, 64)) ])
+
+    fail("an encoder past the per-array limit was accepted")
+except RuntimeError as e:
+    if "IO 1" not in str(e) or "3288334336" not in str(e):
+        fail("unexpected error: " + str(e))
+
+# small structures are unaffected
+h = neo.Hierarchy([ neo.IODesc((4, 4, 16), up_radius=3) ], [ neo.LayerDesc(hidden_size=(4, 4, 16)) ])
+
+if h.get_num_io() != 1:
+    fail("small hierarchy did not construct")
+
+print("ok")
@@ -0,0 +1,97 @@
+# -*- coding: utf-8 -*-
+
+# ----------------------------------------------------------------------------
+#  PyAOgmaNeo
+#  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+#
+#  This copy of PyAOgmaNeo is licensed to you under the terms described
+#  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+# ----------------------------------------------------------------------------
+
+# round trip of indexed files through their per-part sections, on a hierarchy with a prediction and an action IO
+# exits non-zero on a mismatch, registered with CTest when benchmarks are built
+
+import pyaogmaneo as neo
+import numpy as np
+import os
+import tempfile
+
+neo.set_num_threads(1)
+neo.set_global_state(1234)
+
+def fail(message):
+    print("FAIL: " + message)
+
+    raise SystemExit(1)
+
+def make_hierarchy():
+    return neo.Hierarchy([ neo.IODesc((4, 4, 16), neo.prediction), neo.IODesc((2, 2, 8), neo.action) ],
+        [ neo.LayerDesc((4, 4, 16)), neo.LayerDesc((4, 4, 16)) ])
+
+rng = np.random.default_rng(0)
+
+h = make_hierarchy()
+
+for t in range(20):
+    h.step([ rng.integers(0, 16, size=16, dtype=np.int32), rng.integers(0, 8, size=4, dtype=np.int32) ], True, float(rng.random()))
+
+weights = h.serialize_weights_to_buffer()
+state = h.serialize_state_to_buffer()
+
+for compress in [ False, True ]:
+    file_name = os.path.join(tempfile.gettempdir(), "pyaogmaneo_check_indexed_sections.ohr")
+
+    try:
+        h.save_to_file(file_name, compress, True)
+
+        names = [ section["name"] for section in neo.Hierarchy.read_file_info(file_name)["sections"] ]
+
+        for name in [ "meta", "struct", "state", "enc0", "enc1", "dec0_0", "act1", "dec1" ]:
+            if name not in names:
+                fail(f"section {name} missing (compress={compress}), sections are {names}")
+
+        if "dec0_1" in names:
+            fail("action IO written as a decoder")
+
+        if not np.array_equal(h.serialize_weights_to_buffer(), weights) or not np.array_equal(h.serialize_state_to_buffer(), state):
+            fail(f"saving changed the live model (compress={compress})")
+
+        # whole model, structure queries must not load it
+        loaded = neo.Hierarchy(file_name=file_name)
+
+        if loaded.get_num_io() != h.get_num_io() or loaded.get_num_layers() != h.get_num_layers() or \
+            [ loaded.get_hidden_size(l) for l in range(2) ] != [ h.get_hidden_size(l) for l in range(2) ] or \
+            [ loaded.get_io_type(i) for i in range(2) ] != [ h.get_io_type(i) for i in range(2) ] or \
+            [ loaded.get_up_radius(l) for l in range(2) ] != [ h.get_up_radius(l) for l in range(2) ]:
+            fail(f"structure differs before loading (compress={compress})")
+
+        field, field_size = loaded.get_encoder_receptive_field(1, 0, (1, 2, 3))
+        expected_field, expected_field_size = h.get_encoder_receptive_field(1, 0, (1, 2, 3))
+
+        if not np.array_equal(field, expected_field) or field_size != expected_field_size:
+            fail(f"receptive field differs before loading (compress={compress})")
+
+        if loaded.is_loaded():
+            fail(f"structure queries loaded the model (compress={compress})")
+
+        if not np.array_equal(loaded.serialize_weights_to_buffer(), weights):
+            fail(f"weights differ after loading (compress={compress})")
+
+        if not np.array_equal(loaded.serialize_state_to_buffer(), state):
+            fail(f"state differs after loading (compress={compress})")
+
+        # single parts into a fresh hierarchy of the same structure
+        partial = make_hierarchy()
+
+        partial.load_sections_from_file(file_name, [ name for name in names if name not in [ "meta", "struct" ] ])
+
+        if not np.array_equal(partial.serialize_weights_to_buffer(), weights):
+            fail(f"weights differ after loading every part (compress={compress})")
+
+        if not np.array_equal(partial.serialize_state_to_buffer(), state):
+            fail(f"state differs after loading the state section (compress={compress})")
+    finally:
+        if os.path.exists(file_name):
+            os.remove(file_name)
+
+print("ok")
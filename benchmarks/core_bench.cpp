@@ -0,0 +1,163 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+// step latency and throughput of aon::Hierarchy::step and aon::Image_Encoder::step, without any binding code
+
+#include "bench_common.h"
+
+#include <aogmaneo/hierarchy.h>
+#include <aogmaneo/image_encoder.h>
+
+using namespace bench;
+
+namespace {
+void bench_hierarchy(
+    const Options &options,
+    const std::vector<int> &threads,
+    Json_Results &results
+) {
+    std::vector<int> layer_counts = { 1, 2, 4 };
+    std::vector<aon::Int3> hidden_sizes = { aon::Int3(4, 4, 16), aon::Int3(8, 8, 32), aon::Int3(16, 16, 32) };
+    std::vector<int> radii = { 1, 2, 3 };
+    std::vector<aon::IO_Type> io_types = { aon::prediction, aon::action };
+
+    if (options.quick) {
+        layer_counts = { 2 };
+        hidden_sizes = { aon::Int3(8, 8, 32) };
+        radii = { 2 };
+    }
+
+    aon::Int3 io_size(8, 8, 16);
+
+    for (int num_layers : layer_counts)
+        for (const aon::Int3 &hidden_size : hidden_sizes)
+            for (int radius : radii)
+                for (aon::IO_Type io_type : io_types) {
+                    aon::global_state = 1234;
+
+                    aon::Array<aon::Hierarchy::IO_Desc> io_descs(1);
+
+                    io_descs[0] = aon::Hierarchy::IO_Desc(io_size, io_type, 4, radius, radius, 128, 4, 512);
+
+                    aon::Array<aon::Hierarchy::Layer_Desc> layer_descs(num_layers);
+
+                    for (int l = 0; l < num_layers; l++)
+                        layer_descs[l] = aon::Hierarchy::Layer_Desc(hidden_size, 4, radius, 0, radius);
+
+                    aon::Hierarchy h;
+
+                    h.init_random(io_descs, layer_descs);
+
+                    aon::Int_Buffer input(io_size.x * io_size.y);
+                    aon::Array<aon::Int_Buffer_View> inputs(1);
+
+                    for (int num_threads : threads) {
+                        aon::set_num_threads(num_threads);
+
+                        for (int learn = 0; learn < 2; learn++) {
+                            Stats stats = measure(options, [&](int t) {
+                                // moving pattern, so learning has something to do
+                                for (int j = 0; j < input.size(); j++)
+                                    input[j] = (j + t) % io_size.z;
+
+                                inputs[0] = input;
+
+                                h.step(inputs, learn, 1.0f, 0.0f);
+                            });
+
+                            results.add({
+                                { "bench", quote("hierarchy_step") },
+                                { "num_layers", std::to_string(num_layers) },
+                                { "hidden_size", int3_to_json(hidden_size) },
+                                { "radius", std::to_string(radius) },
+                                { "io_type", quote(io_type == aon::action ? "action" : "prediction") },
+                                { "io_size", int3_to_json(io_size) },
+                                { "num_threads", std::to_string(num_threads) },
+                                { "learn_enabled", learn ? "true" : "false" }
+                            }, stats);
+                        }
+                    }
+                }
+}
+
+void bench_image_encoder(
+    const Options &options,
+    const std::vector<int> &threads,
+    Json_Results &results
+) {
+    std::vector<aon::Int3> hidden_sizes = { aon::Int3(8, 8, 16), aon::Int3(16, 16, 32) };
+    std::vector<aon::Int3> visible_sizes = { aon::Int3(32, 32, 3), aon::Int3(64, 64, 3) };
+    std::vector<int> radii = { 4, 8 };
+
+    if (options.quick) {
+        hidden_sizes = { aon::Int3(16, 16, 32) };
+        visible_sizes = { aon::Int3(32, 32, 3) };
+        radii = { 4 };
+    }
+
+    for (const aon::Int3 &hidden_size : hidden_sizes)
+        for (const aon::Int3 &visible_size : visible_sizes)
+            for (int radius : radii) {
+                aon::global_state = 1234;
+
+                aon::Array<aon::Image_Encoder::Visible_Layer_Desc> visible_layer_descs(1);
+
+                visible_layer_descs[0].size = visible_size;
+                visible_layer_descs[0].radius = radius;
+
+                aon::Image_Encoder enc;
+
+                enc.init_random(hidden_size, visible_layer_descs);
+
+                aon::Byte_Buffer image(visible_size.x * visible_size.y * visible_size.z);
+                aon::Array<aon::Byte_Buffer_View> inputs(1);
+
+                for (int num_threads : threads) {
+                    aon::set_num_threads(num_threads);
+
+                    for (int learn = 0; learn < 2; learn++) {
+                        Stats stats = measure(options, [&](int t) {
+                            for (int j = 0; j < image.size(); j++)
+                                image[j] = (j * 7 + t * 13) & 0xff;
+
+                            inputs[0] = image;
+
+                            enc.step(inputs, learn, false);
+                        });
+
+                        results.add({
+                            { "bench", quote("image_encoder_step") },
+                            { "hidden_size", int3_to_json(hidden_size) },
+                            { "visible_size", int3_to_json(visible_size) },
+                            { "radius", std::to_string(radius) },
+                            { "num_threads", std::to_string(num_threads) },
+                            { "learn_enabled", learn ? "true" : "false" }
+                        }, stats);
+                    }
+                }
+            }
+}
+}
+
+int main(
+    int argc,
+    char** argv
+) {
+    Options options = parse_options(argc, argv);
+
+    std::vector<int> threads = thread_counts(options.quick);
+
+    Json_Results results("core");
+
+    bench_hierarchy(options, threads, results);
+    bench_image_encoder(options, threads, results);
+
+    results.write(options);
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+# -*- coding: utf-8 -*-
+
+# ----------------------------------------------------------------------------
+#  PyAOgmaNeo
+#  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+#
+#  This copy of PyAOgmaNeo is licensed to you under the terms described
+#  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+# ----------------------------------------------------------------------------
+
+# save/load/step round trip of a hierarchy larger than 4 GB, to check that nothing in the bindings truncates sizes or offsets
+# aon::Array sizes and indices are int, so each single weight array must stay below 2^31 entries, only totals, streams and
+# offsets are 64-bit: the model is spread over several IOs, each an encoder visible layer of
+# hidden cells x (2 radius + 1)^2 x io z weights (about 1.2e9 with the defaults, so about 4.5 GiB in the encoder alone)
+# needs roughly 3x the model size in memory and 1x on disk, adjust --num-io, --io-size and --radius to scale it
+
+import pyaogmaneo as neo
+import numpy as np
+import argparse
+import os
+import tempfile
+import time
+
+parser = argparse.ArgumentParser()
+parser.add_argument("--hidden-size", type=int, nargs=3, default=[ 64, 64, 32 ])
+parser.add_argument("--io-size", type=int, nargs=3, default=[ 64, 64, 32 ])
+parser.add_argument("--num-io", type=int, default=4)
+parser.add_argument("--radius", type=int, default=8)
+parser.add_argument("--steps", type=int, default=3)
+parser.add_argument("--dir", type=str, default=tempfile.gettempdir())
+args = parser.parse_args()
+
+neo.set_num_threads(os.cpu_count())
+neo.set_global_state(1234)
+
+gb = 1024.0 ** 3
+
+io_size = tuple(args.io_size)
+
+max_array_size = 2 ** 31 - 1
+
+encoder_array_size = args.hidden_size[0] * args.hidden_size[1] * args.hidden_size[2] * (2 * args.radius + 1) ** 2 * io_size[2]
+
+if encoder_array_size > max_array_size:
+    raise SystemExit(f"error: each encoder weight array would have {encoder_array_size} entries, more than an aon::Array can index ({max_array_size}), use more IOs of a smaller size instead")
+
+def timed(name, f):
+    start_time = time.perf_counter()
+    result = f()
+    print(f"{name:<32} {time.perf_counter() - start_time:8.2f} s")
+
+    return result
+
+h = timed("init_random", lambda: neo.Hierarchy([ neo.IODesc(io_size, neo.prediction, up_radius=args.radius, down_radius=2) for _ in range(args.num_io) ],
+    [ neo.LayerDesc(tuple(args.hidden_size), up_radius=2, down_radius=2) ]))
+
+print(f"size {h.get_size() / gb:.2f} GB (weights {h.get_weights_size() / gb:.2f} GB, state {h.get_state_size() / gb:.4f} GB)")
+
+if h.get_size() < 4 * gb:
+    print("warning: model is below 4 GB, increase --num-io or --radius to cover 64-bit offsets")
+
+rng = np.random.default_rng(0)
+
+inputs = [ [ rng.integers(0, io_size[2], size=io_size[0] * io_size[1], dtype=np.int32) for _ in range(args.num_io) ] for _ in range(args.steps) ]
+
+def run(hierarchy):
+    predictions = []
+
+    for t in range(args.steps):
+        hierarchy.step(inputs[t], False)
+
+        predictions.append([ hierarchy.get_prediction_cis(i) for i in range(args.num_io) ])
+
+    return predictions
+
+def check(name, a, b):
+    same = all(np.array_equal(x, y) for xs, ys in zip(a, b) for x, y in zip(xs, ys))
+
+    print(f"{name:<32} {'ok' if same else 'MISMATCH'}")
+
+    if not same:
+        raise SystemExit(1)
+
+state = h.serialize_state_to_buffer()
+
+expected = timed("step (original)", lambda: run(h))
+
+h.set_state_from_buffer(state)
+
+# buffer round trip
+buf = timed("serialize_to_buffer", lambda: h.serialize_to_buffer())
+
+assert buf.nbytes >= h.get_size(), "serialized buffer is smaller than get_size()"
+
+h2 = timed("init (buffer)", lambda: neo.Hierarchy(buffer=buf))
+
+del buf
+
+check("buffer round trip", expected, run(h2))
+
+del h2
+
+# file round trip
+file_name = os.path.join(args.dir, "pyaogmaneo_large_round_trip.ohr")
+
+try:
+    timed("save_to_file", lambda: h.save_to_file(file_name))
+
+    print(f"file size {os.path.getsize(file_name) / gb:.2f} GB")
+
+    h3 = timed("init (file_name)", lambda: neo.Hierarchy(file_name=file_name))
+
+    check("file round trip", expected, run(h3))
+finally:
+    if os.path.exists(file_name):
+        os.remove(file_name)
@@ -0,0 +1,131 @@
+# -*- coding: utf-8 -*-
+
+# ----------------------------------------------------------------------------
+#  PyAOgmaNeo
+#  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+#
+#  This copy of PyAOgmaNeo is licensed to you under the terms described
+#  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+# ----------------------------------------------------------------------------
+
+# measures serialization throughput (MB/s) of Hierarchy and ImageEncoder
+# run once against the previous release and once against the current build to compare
+
+import pyaogmaneo as neo
+import numpy as np
+import mmap
+import os
+import tempfile
+import time
+
+neo.set_num_threads(4)
+
+repeats = 5
+
+def mb_per_s(num_bytes, seconds):
+    return num_bytes / (1024.0 * 1024.0) / max(1e-9, seconds)
+
+def time_best(f):
+    best = float("inf")
+
+    for _ in range(repeats):
+        start_time = time.perf_counter()
+        f()
+        end_time = time.perf_counter()
+
+        best = min(best, end_time - start_time)
+
+    return best
+
+def report(name, num_bytes, seconds):
+    print(f"{name:<48} {num_bytes / (1024.0 * 1024.0):10.2f} MB {mb_per_s(num_bytes, seconds):12.2f} MB/s")
+
+def bench(name, cls, make, serialize_state, serialize_weights, set_state, set_weights):
+    obj = make()
+
+    buf = obj.serialize_to_buffer()
+
+    report(name + " serialize_to_buffer", buf.nbytes, time_best(lambda: obj.serialize_to_buffer()))
+
+    try:
+        compressed = obj.serialize_to_buffer(compress=True)
+
+        print(f"{name} compressed size: {compressed.nbytes} of {buf.nbytes} bytes ({compressed.nbytes / max(1, buf.nbytes) * 100.0:.1f}%)")
+
+        report(name + " serialize_to_buffer (compress)", buf.nbytes, time_best(lambda: obj.serialize_to_buffer(compress=True)))
+        report(name + " init (buffer=compressed)", buf.nbytes, time_best(lambda: cls(buffer=compressed)))
+    except TypeError:
+        print(name + " compression not supported by this build")
+    report(name + " serialize_state_to_buffer", obj.get_state_size(), time_best(lambda: serialize_state(obj)))
+    report(name + " serialize_weights_to_buffer", obj.get_weights_size(), time_best(lambda: serialize_weights(obj)))
+
+    state = serialize_state(obj)
+    weights = serialize_weights(obj)
+
+    report(name + " set_state_from_buffer", state.nbytes, time_best(lambda: set_state(obj, state)))
+    report(name + " set_weights_from_buffer", weights.nbytes, time_best(lambda: set_weights(obj, weights)))
+
+    report(name + " init (buffer=ndarray)", buf.nbytes, time_best(lambda: cls(buffer=buf)))
+
+    # the following only work with buffer protocol support
+    try:
+        b = buf.tobytes()
+
+        report(name + " init (buffer=bytes)", buf.nbytes, time_best(lambda: cls(buffer=b)))
+        report(name + " init (buffer=memoryview)", buf.nbytes, time_best(lambda: cls(buffer=memoryview(b))))
+
+        with tempfile.TemporaryDirectory() as d:
+            file_name = os.path.join(d, "model.bin")
+
+            with open(file_name, "wb") as f:
+                f.write(b)
+
+            with open(file_name, "rb") as f:
+                mm = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+                report(name + " init (buffer=mmap)", buf.nbytes, time_best(lambda: cls(buffer=mm)))
+
+                mm.close()
+    except TypeError:
+        print(name + " buffer protocol inputs not supported by this build")
+
+def make_hierarchy():
+    lds = []
+
+    for i in range(3):
+        ld = neo.LayerDesc()
+
+        ld.hidden_size = (16, 16, 64)
+
+        lds.append(ld)
+
+    return neo.Hierarchy([ neo.IODesc((16, 16, 32), neo.prediction), neo.IODesc((4, 4, 16), neo.action) ], lds)
+
+def make_image_encoder():
+    return neo.ImageEncoder((32, 32, 32), [ neo.ImageVisibleLayerDesc((64, 64, 3), 8) ])
+
+bench("Hierarchy", neo.Hierarchy, make_hierarchy,
+    lambda h: h.serialize_state_to_buffer(),
+    lambda h: h.serialize_weights_to_buffer(),
+    lambda h, b: h.set_state_from_buffer(b),
+    lambda h, b: h.set_weights_from_buffer(b))
+
+bench("ImageEncoder", neo.ImageEncoder, make_image_encoder,
+    lambda e: e.serialize_state_to_buffer(),
+    lambda e: e.serialize_weights_to_buffer(),
+    lambda e, b: e.set_state_from_buffer(b),
+    lambda e, b: e.set_weights_from_buffer(b))
+
+# delta checkpoints, one step after the base
+h = make_hierarchy()
+
+base = h.serialize_state_to_buffer()
+
+h.step([ np.zeros(256, dtype=np.int32), np.zeros(16, dtype=np.int32) ], True)
+
+delta = h.serialize_state_delta(base)
+
+print(f"Hierarchy state delta after one step: {delta.nbytes} of {base.nbytes} bytes")
+
+report("Hierarchy serialize_state_delta", base.nbytes, time_best(lambda: h.serialize_state_delta(base)))
+report("Hierarchy apply_state_delta", base.nbytes, time_best(lambda: h.apply_state_delta(base, delta)))
@@ -0,0 +1,72 @@
+# -*- coding: utf-8 -*-
+
+# ----------------------------------------------------------------------------
+#  PyAOgmaNeo
+#  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+#
+#  This copy of PyAOgmaNeo is licensed to you under the terms described
+#  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+# ----------------------------------------------------------------------------
+
+# measures total step throughput of independent hierarchies stepped from Python threads
+# with the GIL released during step, throughput should scale with the number of threads
+
+import pyaogmaneo as neo
+import numpy as np
+import threading
+import time
+
+steps_per_thread = 200
+
+def make_hierarchy():
+    lds = []
+
+    for i in range(2):
+        ld = neo.LayerDesc()
+
+        ld.hidden_size = (8, 8, 32)
+
+        lds.append(ld)
+
+    return neo.Hierarchy([ neo.IODesc((4, 4, 16), neo.prediction) ], lds)
+
+def run(h, barrier):
+    csdr = np.zeros(16, dtype=np.int32)
+
+    barrier.wait()
+
+    for t in range(steps_per_thread):
+        csdr[:] = t % 16
+
+        h.step([ csdr ], True)
+
+# one OpenMP thread per stepping thread, so the scaling comes from the GIL release alone
+neo.set_num_threads(1)
+
+baseline = None
+
+for num_threads in [ 1, 2, 4, 8 ]:
+    hs = [ make_hierarchy() for _ in range(num_threads) ]
+
+    barrier = threading.Barrier(num_threads + 1)
+
+    threads = [ threading.Thread(target=run, args=(hs[i], barrier)) for i in range(num_threads) ]
+
+    for thread in threads:
+        thread.start()
+
+    barrier.wait()
+
+    start_time = time.perf_counter()
+
+    for thread in threads:
+        thread.join()
+
+    end_time = time.perf_counter()
+
+    steps_per_s = num_threads * steps_per_thread / (end_time - start_time)
+
+    if baseline is None:
+        baseline = steps_per_s
+
+    print(f"{num_threads} threads: {steps_per_s:10.1f} steps/s ({steps_per_s / baseline:.2f}x)")
@@ -11,7 +11,6 @@
 import pyaogmaneo as neo
 import numpy as np
 import gymnasium as gym
-import tinyscaler
 import os
 import time
 
@@ -62,6 +61,11 @@ class EnvRunner:
                     self.input_lows.append(lows)
                     self.input_highs.append(highs)
                     self.input_encs.append(-1)
+
+                    # all continuous, encode natively
+                    if np.all(lows != highs):
+                        self.scalar_encs[len(self.input_sizes) - 1] = neo.ScalarEncoder(len(lows), obs_resolution, neo.ScalarEncoding.sigmoid,
+                            sensitivity=self.inf_sensitivity, num_columns=square_size * square_size)
                 elif len(obs_space.shape) == 2 or len(obs_space.shape) == 3:
                     scaled_size = (int(obs_space.shape[0] * image_scale), int(obs_space.shape[1] * image_scale), 1 if len(obs_space.shape) == 2 else obs_space.shape[2])
 
@@ -72,7 +76,7 @@ class EnvRunner:
                     self.input_sizes.append(hidden_size)
                     self.input_types.append(input_type_none)
                     self.input_lows.append([0.0])
-                    self.input_highs.append([1.0])
+                    self.input_highs.append([255.0])
                     self.input_encs.append(len(self.image_encs))
 
                     self.image_encs.append(image_enc)
@@ -105,6 +109,7 @@ class EnvRunner:
         self.input_encs = []
         self.image_encs = []
         self.image_sizes = []
+        self.scalar_encs = {}
         self.action_indices = []
 
         self.reward_scale = reward_scale
@@ -189,23 +194,25 @@ class EnvRunner:
 
         self.h = neo.Hierarchy(io_descs, lds)
 
-        self.actions = []
+        # native action decoders, these start with random actions
+        self.action_decs = []
 
         for i in range(len(self.action_indices)):
             index = self.action_indices[i]
 
             self.h.params.ios[index].importance = action_importance
 
-            size = self.h.get_io_size(index)[0] * self.h.get_io_size(index)[1]
-
-            start_act = []
-
-            for _ in range(size):
-                start_act.append(np.random.randint(0, self.input_sizes[index][2]))
+            if type(self.env.action_space) is gym.spaces.Box:
+                lows = np.ravel(self.input_lows[index])
+                highs = np.ravel(self.input_highs[index])
+            elif type(self.env.action_space) is gym.spaces.multi_discrete:
+                lows = highs = np.zeros(len(self.env.action_space.nvec))
+            else:
+                lows = highs = [0.0]
 
-            self.actions.append(start_act)
+            self.action_decs.append(neo.ActionDecoder(self.h, index, lows, highs))
 
-        self.actions = np.array(self.actions, np.int32)
+        self.has_stepped = False
 
         self.obs_space = obs_space
 
@@ -224,20 +231,18 @@ class EnvRunner:
                 sub_obs = sub_obs[self.input_keys[i]]
 
             if self.input_types[i] == input_type_action:
-                self.inputs.append(self.actions[action_index])
+                self.inputs.append(self.action_decs[action_index].get_actions(copy=False))
 
                 action_index += 1
             elif self.input_encs[i] != -1:
-                # format image
-                img = tinyscaler.scale((sub_obs - self.input_lows[i]) / (self.input_highs[i][0] - self.input_lows[i][0]),
-                                       (self.image_sizes[image_enc_index][1], self.image_sizes[image_enc_index][0]))
-                
-                # encode image
-                self.image_encs[image_enc_index].step([img.astype(np.uint8).ravel()], True)
+                # normalize, scale and encode image natively
+                self.image_encs[image_enc_index].step_images([sub_obs], self.input_lows[i][0], self.input_highs[i][0], True)
 
                 self.inputs.append(self.image_encs[image_enc_index].get_hidden_cis())
 
                 image_enc_index += 1
+            elif i in self.scalar_encs:
+                self.inputs.append(self.scalar_encs[i].encode(sub_obs.ravel()))
             else:
                 sub_obs = sub_obs.ravel()
 
@@ -266,36 +271,16 @@ class EnvRunner:
         feed_actions = []
 
         for i in range(len(self.action_indices)):
-            index = self.action_indices[i]
-
-            assert(self.input_types[index] == input_type_action)
-
-            if self.input_lows[index][0] < self.input_highs[index][0]:
-                feed_action = []
-
-                # explore
-                for j in range(len(self.input_lows[index])):
-                    if np.random.rand() < epsilon:
-                        self.actions[i][j] = np.random.randint(0, self.input_sizes[index][2])
-
-                    if self.input_lows[index][j] < self.input_highs[index][j]:
-                        feed_action.append(self.actions[i][j] / float(self.input_sizes[index][2] - 1) * (self.input_highs[index][j] - self.input_lows[index][j]) + self.input_lows[index][j])
-                    else:
-                        feed_action.append(self.actions[i][j])
-
-                feed_actions.append(feed_action)
+            # explore and map to the action space, starting from the random actions before the first step
+            if self.has_stepped:
+                values = self.action_decs[i].decode(self.h, epsilon)
             else:
-                if type(self.env.action_space) is gym.spaces.multi_discrete:
-                    for j in range(len(self.env.action_space.nvec)):
-                        if np.random.rand() < epsilon:
-                            self.actions[i][j] = np.random.randint(0, self.input_sizes[index][2])
+                values = self.action_decs[i].get_values()
 
-                        feed_actions.append(int(self.actions[i][j]))
-                else:
-                    if np.random.rand() < epsilon:
-                        self.actions[i][0] = np.random.randint(0, self.input_sizes[index][2])
-
-                    feed_actions.append(int(self.actions[i][0]))
+            if type(self.env.action_space) is gym.spaces.Box:
+                feed_actions.append(values)
+            else:
+                feed_actions += [ int(v) for v in values ]
 
         # remove outer array if needed
         if len(feed_actions) == 1:
@@ -322,12 +307,7 @@ class EnvRunner:
         #if term or trunc:
         #    print((end_time - start_time) * 1000.0)
 
-        # retrieve actions
-        for i in range(len(self.action_indices)):
-            index = self.action_indices[i]
-
-            assert self.input_types[index] == input_type_action
-
-            self.actions[i] = self.h.get_prediction_cis(index)
+        # actions are read from the hierarchy by the decoders on the next act
+        self.has_stepped = True
 
         return term or trunc, reward
@@ -33,6 +33,7 @@ def csdr_to_unorm8(csdr):
     return (csdr[0] | (csdr[1] << 4)) / 255.0
 
 # some other ways of encoding individual scalers:
+# (these are also available natively for whole arrays, see neo.ScalarEncoder with neo.ScalarEncoding.multi_scale and neo.ScalarEncoding.ieee)
 
 # multi-scale embedding
 def f_to_csdr(x, num_columns, cells_per_column, scale_factor=0.25):
@@ -101,6 +102,9 @@ for i in range(3): # layers
 # create the hierarchy with a single IO layer of size (1 x num_input_columns x input_column_size) and type prediction
 h = neo.Hierarchy([ neo.IODesc(size=(1, num_input_columns, input_column_size), io_type=neo.prediction) ], lds)
 
+# small hierarchies like this one often step fastest on few threads, pick the thread counts by measurement instead
+h.autotune()
+
 # present the wave sequence for some timesteps, 1000 here
 iters = 10000
 
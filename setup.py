@@ -26,10 +26,24 @@ class CMakeExtension(Extension):
         Extension.__init__(self, name, sources=[
             "source/pyaogmaneo/py_helpers.h",
             "source/pyaogmaneo/py_helpers.cpp",
+            "source/pyaogmaneo/py_compression.h",
+            "source/pyaogmaneo/py_compression.cpp",
+            "source/pyaogmaneo/py_async_save.h",
+            "source/pyaogmaneo/py_async_save.cpp",
+            "source/pyaogmaneo/py_execution.h",
+            "source/pyaogmaneo/py_execution.cpp",
+            "source/pyaogmaneo/py_container.h",
+            "source/pyaogmaneo/py_container.cpp",
             "source/pyaogmaneo/py_hierarchy.h",
             "source/pyaogmaneo/py_hierarchy.cpp",
+            "source/pyaogmaneo/py_hierarchy_pool.h",
+            "source/pyaogmaneo/py_hierarchy_pool.cpp",
+            "source/pyaogmaneo/py_action_decoder.h",
+            "source/pyaogmaneo/py_action_decoder.cpp",
             "source/pyaogmaneo/py_image_encoder.h",
             "source/pyaogmaneo/py_image_encoder.cpp",
+            "source/pyaogmaneo/py_scalar_encoder.h",
+            "source/pyaogmaneo/py_scalar_encoder.cpp",
             "source/pyaogmaneo/py_module.cpp",
             ])
 
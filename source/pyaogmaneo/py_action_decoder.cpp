@@ -0,0 +1,120 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "py_action_decoder.h"
+
+using namespace pyaon;
+
+Action_Decoder::Action_Decoder(
+    const Hierarchy &hierarchy,
+    int io_index,
+    const std::vector<float> &lows,
+    const std::vector<float> &highs
+)
+:
+io_index(io_index)
+{
+    if (io_index < 0 || io_index >= hierarchy.model().get_num_io())
+        throw std::runtime_error("error: " + std::to_string(io_index) + " is not a valid input index!");
+
+    if (hierarchy.model().get_io_type(io_index) != aon::action)
+        throw std::runtime_error("error: IO at index " + std::to_string(io_index) + " is not of type action!");
+
+    if (lows.size() != highs.size())
+        throw std::runtime_error("error: lows and highs must have the same size!");
+
+    aon::Int3 io_size = hierarchy.model().get_io_size(io_index);
+
+    num_columns = io_size.x * io_size.y;
+    column_size = io_size.z;
+
+    // without ranges, every column is a discrete action
+    num_values = (lows.empty() ? num_columns : lows.size());
+
+    if (num_values > num_columns)
+        throw std::runtime_error("error: " + std::to_string(num_values) + " action ranges given, but the action IO only has " + std::to_string(num_columns) + " columns!");
+
+    this->lows.resize(num_values);
+    this->highs.resize(num_values);
+
+    for (int j = 0; j < num_values; j++) {
+        // low == high means discrete, the index is passed through
+        this->lows[j] = (lows.empty() ? 0.0f : lows[j]);
+        this->highs[j] = (highs.empty() ? 0.0f : highs[j]);
+    }
+
+    actions.resize(num_columns);
+    values.resize(num_values);
+
+    rand_state = new_stream_seed();
+
+    randomize();
+}
+
+void Action_Decoder::map_values() {
+    float max_index_inv = 1.0f / aon::max(1, column_size - 1);
+
+    for (int j = 0; j < num_values; j++) {
+        if (lows[j] < highs[j])
+            values[j] = lows[j] + actions[j] * max_index_inv * (highs[j] - lows[j]);
+        else
+            values[j] = actions[j];
+    }
+}
+
+py::array_t<float> Action_Decoder::decode(
+    const Hierarchy &hierarchy,
+    float epsilon,
+    bool copy,
+    const py::object &out
+) {
+    aon::Int3 io_size = hierarchy.model().get_io_size(io_index);
+
+    if (io_size.x * io_size.y != num_columns || io_size.z != column_size)
+        throw std::runtime_error("error: hierarchy action IO at index " + std::to_string(io_index) + " does not match the size this decoder was created with!");
+
+    const aon::Int_Buffer &cis = hierarchy.model().get_prediction_cis(io_index);
+
+    for (int j = 0; j < num_columns; j++)
+        actions[j] = cis[j];
+
+    if (epsilon > 0.0f) {
+        for (int j = 0; j < num_values; j++) {
+            if (stream_randf(rand_state) < epsilon)
+                actions[j] = stream_rand(rand_state) % column_size;
+        }
+    }
+
+    map_values();
+
+    return buffer_to_numpy(values, copy, out, this);
+}
+
+void Action_Decoder::randomize() {
+    for (int j = 0; j < num_columns; j++)
+        actions[j] = stream_rand(rand_state) % column_size;
+
+    map_values();
+}
+
+void Action_Decoder::set_actions(
+    const py::array_t<int, py::array::c_style | py::array::forcecast> &actions
+) {
+    if (actions.size() != num_columns)
+        throw std::runtime_error("incorrect number of actions! expected " + std::to_string(num_columns) + ", got " + std::to_string(actions.size()));
+
+    const int* data = actions.data();
+
+    if (!cis_in_range(data, num_columns, column_size))
+        throw std::runtime_error("actions have out-of-bounds column indices, they must be in the range [0, " + std::to_string(column_size - 1) + "]");
+
+    for (int j = 0; j < num_columns; j++)
+        this->actions[j] = data[j];
+
+    map_values();
+}
@@ -0,0 +1,83 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "py_hierarchy.h"
+
+namespace py = pybind11;
+
+namespace pyaon {
+// turns the predictions of an action IO into environment actions in one call
+// keeps the last action CSDR, which is fed back into Hierarchy.step
+class Action_Decoder : public View_Owner {
+private:
+    int io_index;
+    int num_columns;
+    int column_size;
+    int num_values;
+
+    aon::Int_Buffer actions; // last action CSDR, num_columns
+    aon::Float_Buffer values; // last actions mapped to [low, high], num_values
+
+    aon::Float_Buffer lows;
+    aon::Float_Buffer highs;
+
+    // exploration random stream, independent of aon::global_state
+    std::uint64_t rand_state;
+
+    void map_values();
+
+public:
+    Action_Decoder(
+        const Hierarchy &hierarchy,
+        int io_index,
+        const std::vector<float> &lows,
+        const std::vector<float> &highs
+    );
+
+    // reads the action IO prediction, replaces each value with a random index with probability epsilon, maps to [low, high]
+    // returns the mapped values
+    py::array_t<float> decode(
+        const Hierarchy &hierarchy,
+        float epsilon,
+        bool copy,
+        const py::object &out
+    );
+
+    // fills the action CSDR with uniformly random indices
+    void randomize();
+
+    void set_actions(
+        const py::array_t<int, py::array::c_style | py::array::forcecast> &actions
+    );
+
+    // the last action CSDR, for feeding back into Hierarchy.step
+    py::array_t<int> get_actions(
+        bool copy,
+        const py::object &out
+    ) const {
+        return buffer_to_numpy(actions, copy, out, this);
+    }
+
+    py::array_t<float> get_values(
+        bool copy,
+        const py::object &out
+    ) const {
+        return buffer_to_numpy(values, copy, out, this);
+    }
+
+    int get_io_index() const {
+        return io_index;
+    }
+
+    int get_num_values() const {
+        return num_values;
+    }
+};
+}
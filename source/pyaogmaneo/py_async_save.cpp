@@ -0,0 +1,287 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "py_async_save.h"
+#include "py_compression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace pyaon;
+
+namespace {
+std::atomic<unsigned long> num_temp_files(0);
+
+std::mutex background_mutex;
+std::condition_variable background_cond;
+int num_background_tasks = 0;
+
+// unique per process and call, so overlapping saves to the same file never share a temporary file
+std::string temp_file_name_for(
+    const std::string &file_name
+) {
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = getpid();
+#endif
+
+    return file_name + ".tmp." + std::to_string(pid) + "." + std::to_string(num_temp_files++);
+}
+
+#ifndef _WIN32
+std::string parent_directory(
+    const std::string &file_name
+) {
+    std::string::size_type slash = file_name.find_last_of('/');
+
+    if (slash == std::string::npos)
+        return ".";
+
+    if (slash == 0)
+        return "/";
+
+    return file_name.substr(0, slash);
+}
+#endif
+}
+
+void pyaon::write_file_atomic(
+    const std::string &file_name,
+    const unsigned char* data,
+    long long size
+) {
+    write_file_atomic(file_name, { std::make_pair(data, size) });
+}
+
+void pyaon::write_file_atomic(
+    const std::string &file_name,
+    const std::vector<std::pair<const unsigned char*, long long>> &pieces
+) {
+    std::string temp_file_name;
+
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+
+    // retry if a stale temporary file of an earlier process with the same id is in the way
+    for (int attempt = 0; attempt < 16 && file == INVALID_HANDLE_VALUE; attempt++) {
+        temp_file_name = temp_file_name_for(file_name);
+
+        file = CreateFileA(temp_file_name.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+
+        if (file == INVALID_HANDLE_VALUE && GetLastError() != ERROR_FILE_EXISTS)
+            break;
+    }
+
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("error: could not open " + temp_file_name + " for writing!");
+
+    bool written = true;
+
+    for (int p = 0; p < pieces.size() && written; p++) {
+        const unsigned char* piece = pieces[p].first;
+        long long remaining = pieces[p].second;
+
+        while (remaining > 0) {
+            DWORD piece_written;
+
+            if (!WriteFile(file, piece, static_cast<DWORD>(std::min<long long>(remaining, 1 << 30)), &piece_written, NULL)) {
+                written = false;
+
+                break;
+            }
+
+            piece += piece_written;
+            remaining -= piece_written;
+        }
+    }
+
+    // the data must reach the disk before the rename can make it visible under file_name
+    if (written && !FlushFileBuffers(file))
+        written = false;
+
+    if (!CloseHandle(file))
+        written = false;
+
+    if (!written) {
+        std::remove(temp_file_name.c_str());
+
+        throw std::runtime_error("error: failed writing " + temp_file_name + " - is the disk full?");
+    }
+
+    if (!MoveFileExA(temp_file_name.c_str(), file_name.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        std::remove(temp_file_name.c_str());
+
+        throw std::runtime_error("error: could not rename " + temp_file_name + " to " + file_name + "!");
+    }
+#else
+    int fd = -1;
+
+    // retry if a stale temporary file of an earlier process with the same id is in the way
+    for (int attempt = 0; attempt < 16 && fd == -1; attempt++) {
+        temp_file_name = temp_file_name_for(file_name);
+
+        fd = ::open(temp_file_name.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+
+        if (fd == -1 && errno != EEXIST)
+            break;
+    }
+
+    if (fd == -1)
+        throw std::runtime_error("error: could not open " + temp_file_name + " for writing (" + std::strerror(errno) + ")!");
+
+    int error = 0;
+
+    for (int p = 0; p < pieces.size() && error == 0; p++) {
+        const unsigned char* piece = pieces[p].first;
+        long long remaining = pieces[p].second;
+
+        while (remaining > 0) {
+            ssize_t piece_written = ::write(fd, piece, std::min<long long>(remaining, 1 << 30));
+
+            if (piece_written < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                error = errno;
+
+                break;
+            }
+
+            piece += piece_written;
+            remaining -= piece_written;
+        }
+    }
+
+    // the data must reach the disk before the rename can make it visible under file_name
+    if (error == 0 && ::fsync(fd) != 0)
+        error = errno;
+
+    if (::close(fd) != 0 && error == 0)
+        error = errno;
+
+    if (error != 0) {
+        std::remove(temp_file_name.c_str());
+
+        throw std::runtime_error("error: failed writing " + temp_file_name + " (" + std::strerror(error) + ") - is the disk full?");
+    }
+
+    if (std::rename(temp_file_name.c_str(), file_name.c_str()) != 0) {
+        error = errno;
+
+        std::remove(temp_file_name.c_str());
+
+        throw std::runtime_error("error: could not rename " + temp_file_name + " to " + file_name + " (" + std::strerror(error) + ")!");
+    }
+
+    // persist the rename itself, some filesystems do not support syncing directories, which is not an error
+    int dir_fd = ::open(parent_directory(file_name).c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (dir_fd != -1) {
+        ::fsync(dir_fd);
+        ::close(dir_fd);
+    }
+#endif
+}
+
+void pyaon::begin_background_task() {
+    std::lock_guard<std::mutex> lock(background_mutex);
+
+    num_background_tasks++;
+}
+
+void pyaon::end_background_task() {
+    // notified under the lock, so a waiter returning (and the process exiting) cannot race the notify
+    std::lock_guard<std::mutex> lock(background_mutex);
+
+    num_background_tasks--;
+
+    background_cond.notify_all();
+}
+
+void pyaon::wait_background_tasks() {
+    py::gil_scoped_release release;
+
+    std::unique_lock<std::mutex> lock(background_mutex);
+
+    background_cond.wait(lock, []() { return num_background_tasks == 0; });
+}
+
+Save_Handle::Save_Handle(
+    const std::string &file_name,
+    std::vector<unsigned char> &&snapshot,
+    bool compress
+)
+:
+job(std::make_shared<Job>())
+{
+    std::shared_ptr<Job> j = job;
+
+    // counted before the thread starts, so an exit right after this call still waits for it
+    std::shared_ptr<Background_Task> task = std::make_shared<Background_Task>();
+
+    std::thread thread([j, task, file_name, compress, data = std::move(snapshot)]() mutable {
+        std::string error;
+
+        try {
+            if (compress) {
+                std::vector<unsigned char> compressed;
+
+                compress_to(data.data(), data.size(), compressed);
+
+                write_file_atomic(file_name, compressed.data(), compressed.size());
+            }
+            else
+                write_file_atomic(file_name, data.data(), data.size());
+        }
+        catch (const std::exception &e) {
+            error = e.what();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(j->mutex);
+
+            j->error = error;
+            j->finished = true;
+        }
+
+        j->cond.notify_all();
+
+        task.reset();
+    });
+
+    thread.detach();
+}
+
+void Save_Handle::wait() {
+    std::string error;
+
+    {
+        py::gil_scoped_release release;
+
+        std::unique_lock<std::mutex> lock(job->mutex);
+
+        job->cond.wait(lock, [this]() { return job->finished; });
+
+        error = job->error;
+    }
+
+    if (!error.empty())
+        throw std::runtime_error(error);
+}
@@ -0,0 +1,91 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "py_helpers.h"
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace py = pybind11;
+
+namespace pyaon {
+// writes data to a unique temporary file next to file_name, syncs it to disk, then renames it over file_name (and syncs the directory),
+// so neither readers nor a crash or power loss ever leave a truncated file under file_name
+void write_file_atomic(
+    const std::string &file_name,
+    const unsigned char* data,
+    long long size
+);
+
+// same, for data given as consecutive (pointer, size) pieces
+void write_file_atomic(
+    const std::string &file_name,
+    const std::vector<std::pair<const unsigned char*, long long>> &pieces
+);
+
+// background threads started by the bindings (async saves, weight staging) are counted, so the module can wait for them
+// at interpreter exit (an atexit hook registered on import) instead of killing them mid-write and leaving temporary files
+void begin_background_task();
+
+void end_background_task();
+
+// blocks (with the GIL released) until no background task is running
+void wait_background_tasks();
+
+// counts a background task for the lifetime of a thread's body
+struct Background_Task {
+    Background_Task() {
+        begin_background_task();
+    }
+
+    ~Background_Task() {
+        end_background_task();
+    }
+};
+
+// handle on a background save started by save_to_file_async
+class Save_Handle {
+private:
+    // shared with the background thread, which is detached so dropping the handle never blocks, and waited for at exit
+    struct Job {
+        std::mutex mutex;
+        std::condition_variable cond;
+
+        bool finished;
+        std::string error;
+
+        Job()
+        :
+        finished(false)
+        {}
+    };
+
+    std::shared_ptr<Job> job;
+
+public:
+    // takes ownership of the snapshot, optionally compresses it, and writes it on a background thread
+    Save_Handle(
+        const std::string &file_name,
+        std::vector<unsigned char> &&snapshot,
+        bool compress
+    );
+
+    // blocks (with the GIL released) until the file is in place, rethrows write errors
+    void wait();
+
+    bool done() const {
+        std::lock_guard<std::mutex> lock(job->mutex);
+
+        return job->finished;
+    }
+};
+}
@@ -0,0 +1,400 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "py_compression.h"
+#include "py_async_save.h"
+
+#include <algorithm>
+
+using namespace pyaon;
+
+namespace {
+const int lz_min_match = 4;
+const int lz_last_literals = 5; // the end of a block is always literals, so matches never run to the edge
+const int lz_max_offset = 65535;
+const int lz_hash_bits = 14;
+
+inline std::uint32_t read32(
+    const unsigned char* p
+) {
+    std::uint32_t v;
+
+    std::memcpy(&v, p, sizeof(std::uint32_t));
+
+    return v;
+}
+
+inline int lz_hash(
+    std::uint32_t v
+) {
+    return (v * 2654435761u) >> (32 - lz_hash_bits);
+}
+
+inline void write_length(
+    int len,
+    std::vector<unsigned char> &out
+) {
+    while (len >= 255) {
+        out.push_back(255);
+
+        len -= 255;
+    }
+
+    out.push_back(len);
+}
+
+inline void write_sequence(
+    const unsigned char* literals,
+    int num_literals,
+    int offset,
+    int match_len,
+    std::vector<unsigned char> &out
+) {
+    int match_code = (match_len > 0 ? match_len - lz_min_match : 0);
+
+    out.push_back((aon::min(num_literals, 15) << 4) | aon::min(match_code, 15));
+
+    if (num_literals >= 15)
+        write_length(num_literals - 15, out);
+
+    out.insert(out.end(), literals, literals + num_literals);
+
+    if (match_len == 0)
+        return;
+
+    out.push_back(offset & 0xff);
+    out.push_back(offset >> 8);
+
+    if (match_code >= 15)
+        write_length(match_code - 15, out);
+}
+
+// returns false on a truncated length, or one growing past limit (checked per byte, so len cannot overflow)
+inline bool read_length(
+    const unsigned char* &ip,
+    const unsigned char* end,
+    int limit,
+    int &len
+) {
+    unsigned char b;
+
+    do {
+        if (ip >= end)
+            return false;
+
+        b = *ip++;
+
+        len += b;
+
+        if (len > limit)
+            return false;
+    } while (b == 255);
+
+    return true;
+}
+}
+
+void pyaon::lz_compress(
+    const unsigned char* src,
+    int src_size,
+    std::vector<unsigned char> &out
+) {
+    std::vector<int> table(1 << lz_hash_bits, -1);
+
+    int anchor = 0;
+    int ip = 0;
+
+    int match_limit = src_size - lz_last_literals;
+
+    while (ip + lz_min_match <= match_limit) {
+        std::uint32_t seq = read32(src + ip);
+
+        int h = lz_hash(seq);
+        int ref = table[h];
+
+        table[h] = ip;
+
+        if (ref < 0 || ip - ref > lz_max_offset || read32(src + ref) != seq) {
+            ip++;
+
+            continue;
+        }
+
+        int match_len = lz_min_match;
+
+        while (ip + match_len < match_limit && src[ref + match_len] == src[ip + match_len])
+            match_len++;
+
+        write_sequence(src + anchor, ip - anchor, ip - ref, match_len, out);
+
+        ip += match_len;
+        anchor = ip;
+    }
+
+    write_sequence(src + anchor, src_size - anchor, 0, 0, out);
+}
+
+bool pyaon::lz_decompress(
+    const unsigned char* src,
+    int src_size,
+    unsigned char* dst,
+    int dst_size
+) {
+    const unsigned char* ip = src;
+    const unsigned char* end = src + src_size;
+
+    int op = 0;
+
+    while (ip < end) {
+        unsigned char token = *ip++;
+
+        int num_literals = token >> 4;
+
+        // literals must fit both the input and the output
+        if (num_literals == 15 && !read_length(ip, end, static_cast<int>(std::min<long long>(end - ip, dst_size - op)), num_literals))
+            return false;
+
+        if (num_literals > end - ip || num_literals > dst_size - op)
+            return false;
+
+        std::memcpy(dst + op, ip, num_literals);
+
+        ip += num_literals;
+        op += num_literals;
+
+        // the last sequence has no match
+        if (ip == end)
+            break;
+
+        if (end - ip < 2)
+            return false;
+
+        int offset = ip[0] | (ip[1] << 8);
+
+        ip += 2;
+
+        int match_len = token & 0x0f;
+
+        if (match_len == 15 && !read_length(ip, end, dst_size - op - lz_min_match, match_len))
+            return false;
+
+        match_len += lz_min_match;
+
+        if (offset == 0 || offset > op || match_len > dst_size - op)
+            return false;
+
+        // byte by byte, matches may overlap their own output
+        for (int j = 0; j < match_len; j++)
+            dst[op + j] = dst[op - offset + j];
+
+        op += match_len;
+    }
+
+    return op == dst_size;
+}
+
+bool pyaon::is_compressed(
+    const unsigned char* data,
+    long long size
+) {
+    return size >= compressed_header_size && std::memcmp(data, "AONZ", 4) == 0;
+}
+
+void pyaon::compress_to(
+    const unsigned char* data,
+    long long size,
+    std::vector<unsigned char> &out
+) {
+    int num_chunks = (size + compressed_chunk_size - 1) / compressed_chunk_size;
+
+    std::vector<std::vector<unsigned char>> chunks(num_chunks);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < num_chunks; c++) {
+        long long chunk_start = static_cast<long long>(c) * compressed_chunk_size;
+        int chunk_size = std::min<long long>(compressed_chunk_size, size - chunk_start);
+
+        lz_compress(data + chunk_start, chunk_size, chunks[c]);
+
+        // incompressible, store as-is
+        if (chunks[c].size() >= chunk_size)
+            chunks[c].assign(data + chunk_start, data + chunk_start + chunk_size);
+    }
+
+    long long total_size = compressed_header_size + static_cast<long long>(num_chunks) * sizeof(std::int32_t);
+
+    for (int c = 0; c < num_chunks; c++)
+        total_size += chunks[c].size();
+
+    out.resize(total_size);
+
+    unsigned char version = 1;
+    unsigned char codec = codec_lz;
+    std::uint16_t reserved = 0;
+    std::int32_t chunk_size = compressed_chunk_size;
+    std::int32_t num_chunks32 = num_chunks;
+
+    std::memcpy(&out[0], "AONZ", 4);
+    std::memcpy(&out[4], &version, 1);
+    std::memcpy(&out[5], &codec, 1);
+    std::memcpy(&out[6], &reserved, 2);
+    std::memcpy(&out[8], &size, 8);
+    std::memcpy(&out[16], &chunk_size, 4);
+    std::memcpy(&out[20], &num_chunks32, 4);
+
+    long long pos = compressed_header_size;
+
+    for (int c = 0; c < num_chunks; c++) {
+        std::int32_t compressed_size = chunks[c].size();
+
+        std::memcpy(&out[pos], &compressed_size, 4);
+
+        pos += 4;
+    }
+
+    for (int c = 0; c < num_chunks; c++) {
+        if (!chunks[c].empty())
+            std::memcpy(&out[pos], chunks[c].data(), chunks[c].size());
+
+        pos += chunks[c].size();
+    }
+}
+
+py::array_t<unsigned char> pyaon::compress_buffer(
+    const unsigned char* data,
+    long long size
+) {
+    std::vector<unsigned char> compressed;
+
+    {
+        py::gil_scoped_release release;
+
+        compress_to(data, size, compressed);
+    }
+
+    py::array_t<unsigned char> result(compressed.size());
+
+    std::memcpy(result.mutable_data(), compressed.data(), compressed.size());
+
+    return result;
+}
+
+void pyaon::save_compressed_to_file(
+    const std::string &file_name,
+    const unsigned char* data,
+    long long size
+) {
+    std::vector<unsigned char> compressed;
+
+    py::gil_scoped_release release;
+
+    compress_to(data, size, compressed);
+
+    // throws on any write error, and never leaves a truncated file under file_name
+    write_file_atomic(file_name, compressed.data(), compressed.size());
+}
+
+long long pyaon::get_decompressed_size(
+    const unsigned char* data,
+    long long size
+) {
+    if (!is_compressed(data, size))
+        throw std::runtime_error("error: not a compressed buffer (bad magic)!");
+
+    unsigned char version = data[4];
+    unsigned char codec = data[5];
+
+    if (version != 1)
+        throw std::runtime_error("error: unsupported compressed container version " + std::to_string(version) + "!");
+
+    if (codec != codec_lz)
+        throw std::runtime_error("error: unsupported codec " + std::to_string(codec) + " in compressed container!");
+
+    long long raw_size;
+    std::int32_t chunk_size;
+    std::int32_t num_chunks;
+
+    std::memcpy(&raw_size, data + 8, 8);
+    std::memcpy(&chunk_size, data + 16, 4);
+    std::memcpy(&num_chunks, data + 20, 4);
+
+    if (raw_size < 0 || chunk_size < 1 || num_chunks != (raw_size + chunk_size - 1) / chunk_size)
+        throw std::runtime_error("error: corrupted compressed container header!");
+
+    if (size < compressed_header_size + static_cast<long long>(num_chunks) * 4)
+        throw std::runtime_error("error: compressed container is truncated!");
+
+    return raw_size;
+}
+
+void pyaon::decompress_to(
+    const unsigned char* data,
+    long long size,
+    unsigned char* out
+) {
+    long long raw_size = get_decompressed_size(data, size);
+
+    std::int32_t chunk_size;
+    std::int32_t num_chunks;
+
+    std::memcpy(&chunk_size, data + 16, 4);
+    std::memcpy(&num_chunks, data + 20, 4);
+
+    // chunk offsets from the size table
+    std::vector<long long> chunk_starts(num_chunks + 1);
+
+    chunk_starts[0] = compressed_header_size + static_cast<long long>(num_chunks) * 4;
+
+    for (int c = 0; c < num_chunks; c++) {
+        std::int32_t compressed_size;
+
+        std::memcpy(&compressed_size, data + compressed_header_size + c * 4, 4);
+
+        if (compressed_size < 0)
+            throw std::runtime_error("error: corrupted compressed container chunk table!");
+
+        chunk_starts[c + 1] = chunk_starts[c] + compressed_size;
+    }
+
+    if (chunk_starts[num_chunks] > size)
+        throw std::runtime_error("error: compressed container is truncated!");
+
+    int num_failed = 0;
+
+    #pragma omp parallel for schedule(dynamic) reduction(+:num_failed)
+    for (int c = 0; c < num_chunks; c++) {
+        long long raw_start = static_cast<long long>(c) * chunk_size;
+        int raw_chunk_size = std::min<long long>(chunk_size, raw_size - raw_start);
+        long long compressed_size = chunk_starts[c + 1] - chunk_starts[c];
+
+        if (compressed_size == raw_chunk_size)
+            std::memcpy(out + raw_start, data + chunk_starts[c], raw_chunk_size);
+        else if (!lz_decompress(data + chunk_starts[c], compressed_size, out + raw_start, raw_chunk_size))
+            num_failed++;
+    }
+
+    if (num_failed > 0)
+        throw std::runtime_error("error: compressed container is corrupted (" + std::to_string(num_failed) + " chunks failed to decompress)!");
+}
+
+py::array_t<unsigned char> pyaon::decompress_buffer(
+    const unsigned char* data,
+    long long size
+) {
+    py::array_t<unsigned char> result(get_decompressed_size(data, size));
+
+    unsigned char* out = result.mutable_data();
+
+    {
+        py::gil_scoped_release release;
+
+        decompress_to(data, size, out);
+    }
+
+    return result;
+}
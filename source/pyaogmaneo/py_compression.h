@@ -0,0 +1,146 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "py_helpers.h"
+
+namespace pyaon {
+enum Codec {
+    codec_none = 0,
+    codec_lz = 1
+};
+
+// dependency-free LZ77 block codec in the style of LZ4 (not LZ4 compatible)
+// sequences are a token (literal length << 4 | (match length - 4)), extended lengths, literals, 2-byte offset, extended match length
+// appends the compressed block to out
+void lz_compress(
+    const unsigned char* src,
+    int src_size,
+    std::vector<unsigned char> &out
+);
+
+// returns false if the block is malformed or does not decompress to exactly dst_size bytes
+bool lz_decompress(
+    const unsigned char* src,
+    int src_size,
+    unsigned char* dst,
+    int dst_size
+);
+
+// compressed container, chunks are (de)compressed in parallel
+// layout: "AONZ", uint8 version, uint8 codec, uint16 reserved, int64 raw size, int32 chunk size, int32 number of chunks,
+// int32 compressed size per chunk (equal to the raw chunk size if stored uncompressed), chunk data
+const int compressed_header_size = 24;
+const int compressed_chunk_size = 1 << 20;
+
+bool is_compressed(
+    const unsigned char* data,
+    long long size
+);
+
+// builds the container into out, does not touch Python objects
+void compress_to(
+    const unsigned char* data,
+    long long size,
+    std::vector<unsigned char> &out
+);
+
+// validates the header and returns the size of the decompressed data
+long long get_decompressed_size(
+    const unsigned char* data,
+    long long size
+);
+
+// decompresses into out (get_decompressed_size bytes), does not touch Python objects
+void decompress_to(
+    const unsigned char* data,
+    long long size,
+    unsigned char* out
+);
+
+// the GIL is released while (de)compressing
+py::array_t<unsigned char> compress_buffer(
+    const unsigned char* data,
+    long long size
+);
+
+py::array_t<unsigned char> decompress_buffer(
+    const unsigned char* data,
+    long long size
+);
+
+// compresses and writes to a file in one go, atomically (see write_file_atomic), the GIL is released throughout
+void save_compressed_to_file(
+    const std::string &file_name,
+    const unsigned char* data,
+    long long size
+);
+
+// the container is detected by its header, anything else is read as-is
+template<typename F>
+void read_maybe_compressed(
+    const py::buffer &buffer,
+    F read
+) {
+    Buffer_Reader reader(buffer);
+
+    if (!is_compressed(reader.data, reader.size)) {
+        read(reader);
+
+        return;
+    }
+
+    py::array_t<unsigned char> raw = decompress_buffer(reader.data, reader.size);
+
+    Buffer_Reader raw_reader(raw);
+
+    read(raw_reader);
+}
+
+template<typename F>
+void read_memory_maybe_compressed(
+    const unsigned char* data,
+    long long size,
+    F read
+) {
+    if (!is_compressed(data, size)) {
+        Memory_Reader reader(data, size);
+
+        read(reader);
+
+        return;
+    }
+
+    py::array_t<unsigned char> raw = decompress_buffer(data, size);
+
+    Buffer_Reader raw_reader(raw);
+
+    read(raw_reader);
+}
+
+template<typename F>
+void read_file_maybe_compressed(
+    const std::string &file_name,
+    F read
+) {
+    Mapped_File_Reader reader(file_name);
+
+    if (!is_compressed(reader.file.get_data(), reader.file.get_size())) {
+        read(reader);
+
+        return;
+    }
+
+    py::array_t<unsigned char> raw = decompress_buffer(reader.file.get_data(), reader.file.get_size());
+
+    Buffer_Reader raw_reader(raw);
+
+    read(raw_reader);
+}
+}
@@ -0,0 +1,152 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "py_container.h"
+#include "py_async_save.h"
+
+using namespace pyaon;
+
+std::uint64_t pyaon::checksum64(
+    const unsigned char* data,
+    long long size
+) {
+    const std::uint64_t prime = 0x100000001b3ull;
+
+    std::uint64_t h = 0xcbf29ce484222325ull ^ static_cast<std::uint64_t>(size);
+
+    long long num_words = size / 8;
+
+    for (long long w = 0; w < num_words; w++) {
+        std::uint64_t word;
+
+        std::memcpy(&word, data + w * 8, 8);
+
+        h = (h ^ word) * prime;
+    }
+
+    for (long long j = num_words * 8; j < size; j++)
+        h = (h ^ data[j]) * prime;
+
+    // final avalanche, so changes in high bits reach the low ones
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+
+    return h;
+}
+
+bool pyaon::is_container(
+    const unsigned char* data,
+    long long size
+) {
+    return size >= container_header_size && std::memcmp(data, "AONC", 4) == 0;
+}
+
+std::vector<Container_Section> pyaon::read_container_index(
+    const unsigned char* data,
+    long long size
+) {
+    if (!is_container(data, size))
+        throw std::runtime_error("error: not an indexed container (bad magic)!");
+
+    std::uint32_t version;
+    std::uint32_t num_sections;
+
+    std::memcpy(&version, data + 4, 4);
+    std::memcpy(&num_sections, data + 8, 4);
+
+    if (version != container_version)
+        throw std::runtime_error("error: unsupported container version " + std::to_string(version) + "!");
+
+    long long table_end = container_header_size + static_cast<long long>(num_sections) * container_entry_size;
+
+    if (table_end > size)
+        throw std::runtime_error("error: container section table is truncated!");
+
+    std::vector<Container_Section> sections(num_sections);
+
+    for (int s = 0; s < num_sections; s++) {
+        const unsigned char* entry = data + container_header_size + static_cast<long long>(s) * container_entry_size;
+
+        char name[9] = {};
+
+        std::memcpy(name, entry, 8);
+
+        sections[s].name = name;
+
+        std::memcpy(&sections[s].offset, entry + 8, 8);
+        std::memcpy(&sections[s].size, entry + 16, 8);
+        std::memcpy(&sections[s].checksum, entry + 24, 8);
+
+        if (sections[s].offset < table_end || sections[s].size < 0 || sections[s].offset > size - sections[s].size)
+            throw std::runtime_error("error: container section \"" + sections[s].name + "\" lies outside the data (" + std::to_string(size) + " bytes) - is it truncated?");
+    }
+
+    return sections;
+}
+
+const Container_Section &pyaon::find_section(
+    const std::vector<Container_Section> &sections,
+    const std::string &name
+) {
+    for (int s = 0; s < sections.size(); s++) {
+        if (sections[s].name == name)
+            return sections[s];
+    }
+
+    throw std::runtime_error("error: container has no \"" + name + "\" section!");
+}
+
+void pyaon::verify_section(
+    const unsigned char* data,
+    const Container_Section &section
+) {
+    if (checksum64(data + section.offset, section.size) != section.checksum)
+        throw std::runtime_error("error: container section \"" + section.name + "\" failed its checksum - is the file corrupted?");
+}
+
+void pyaon::save_container(
+    const std::string &file_name,
+    const std::vector<Section_Data> &sections
+) {
+    std::vector<unsigned char> index(container_header_size + sections.size() * container_entry_size, 0);
+
+    std::uint32_t version = container_version;
+    std::uint32_t num_sections = sections.size();
+
+    std::memcpy(&index[0], "AONC", 4);
+    std::memcpy(&index[4], &version, 4);
+    std::memcpy(&index[8], &num_sections, 4);
+
+    long long offset = index.size();
+
+    for (int s = 0; s < sections.size(); s++) {
+        if (sections[s].name.size() > 8)
+            throw std::runtime_error("error: container section name \"" + sections[s].name + "\" is longer than 8 characters!");
+
+        unsigned char* entry = &index[container_header_size + s * container_entry_size];
+
+        std::uint64_t checksum = checksum64(sections[s].data, sections[s].size);
+
+        std::memcpy(entry, sections[s].name.data(), sections[s].name.size());
+        std::memcpy(entry + 8, &offset, 8);
+        std::memcpy(entry + 16, &sections[s].size, 8);
+        std::memcpy(entry + 24, &checksum, 8);
+
+        offset += sections[s].size;
+    }
+
+    std::vector<std::pair<const unsigned char*, long long>> pieces;
+
+    pieces.push_back(std::make_pair(static_cast<const unsigned char*>(index.data()), static_cast<long long>(index.size())));
+
+    for (int s = 0; s < sections.size(); s++)
+        pieces.push_back(std::make_pair(sections[s].data, sections[s].size));
+
+    write_file_atomic(file_name, pieces);
+}
@@ -0,0 +1,80 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "py_helpers.h"
+
+namespace pyaon {
+// indexed container, a table of named and checksummed sections so that small sections can be read without touching the rest
+// layout: "AONC", uint32 version, uint32 number of sections, uint32 reserved,
+// per section: char[8] name (zero padded), int64 offset, int64 size, uint64 checksum, then the section data
+// does not touch Python objects
+const int container_header_size = 16;
+const int container_entry_size = 32;
+const int container_version = 1;
+
+struct Container_Section {
+    std::string name;
+    long long offset;
+    long long size;
+    std::uint64_t checksum;
+};
+
+struct Section_Data {
+    std::string name;
+    const unsigned char* data;
+    long long size;
+
+    Section_Data(
+        const std::string &name,
+        const unsigned char* data,
+        long long size
+    )
+    :
+    name(name),
+    data(data),
+    size(size)
+    {}
+};
+
+// word-at-a-time FNV-1a style hash, detects corruption (not tampering)
+std::uint64_t checksum64(
+    const unsigned char* data,
+    long long size
+);
+
+bool is_container(
+    const unsigned char* data,
+    long long size
+);
+
+// parses and validates the header and section table, every section must lie within size
+std::vector<Container_Section> read_container_index(
+    const unsigned char* data,
+    long long size
+);
+
+// throws if the section is missing
+const Container_Section &find_section(
+    const std::vector<Container_Section> &sections,
+    const std::string &name
+);
+
+// throws if the section data does not match its checksum
+void verify_section(
+    const unsigned char* data,
+    const Container_Section &section
+);
+
+// written atomically, see write_file_atomic
+void save_container(
+    const std::string &file_name,
+    const std::vector<Section_Data> &sections
+);
+}
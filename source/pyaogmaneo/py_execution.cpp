@@ -0,0 +1,165 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "py_execution.h"
+
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+using namespace pyaon;
+
+namespace {
+#ifdef __linux__
+// affinity a thread had before an Execution_Scope pinned it
+thread_local bool has_saved_affinity = false;
+thread_local cpu_set_t saved_affinity;
+
+void make_cpu_set(
+    const std::vector<int> &cpus,
+    cpu_set_t &set
+) {
+    CPU_ZERO(&set);
+
+    for (int c : cpus)
+        CPU_SET(c, &set);
+}
+
+bool pin_calling_thread(
+    const cpu_set_t &set
+) {
+    return sched_setaffinity(0, sizeof(cpu_set_t), &set) == 0;
+}
+
+// a thread that was not restored (e.g. it missed the restoring team) keeps its original saved affinity
+void save_and_pin_calling_thread(
+    const cpu_set_t &set
+) {
+    if (!has_saved_affinity)
+        has_saved_affinity = (sched_getaffinity(0, sizeof(cpu_set_t), &saved_affinity) == 0);
+
+    pin_calling_thread(set);
+}
+
+void restore_calling_thread() {
+    if (!has_saved_affinity)
+        return;
+
+    pin_calling_thread(saved_affinity);
+
+    has_saved_affinity = false;
+}
+#endif
+}
+
+void Execution_Settings::set(
+    int num_threads,
+    const std::vector<int> &cpus
+) {
+#ifdef __linux__
+    for (int c : cpus) {
+        if (c < 0 || c >= CPU_SETSIZE)
+            throw std::runtime_error("error: cpu " + std::to_string(c) + " is out of range [0, " + std::to_string(CPU_SETSIZE - 1) + "]!");
+    }
+#else
+    if (!cpus.empty())
+        throw std::runtime_error("error: pinning to cpus is only supported on Linux!");
+#endif
+
+    set_num_threads(num_threads, num_threads);
+
+    this->cpus = cpus;
+}
+
+void Execution_Settings::set_num_threads(
+    int num_threads_learn,
+    int num_threads_infer
+) {
+    if (num_threads_learn < 0 || num_threads_infer < 0)
+        throw std::runtime_error("error: num_threads must be >= 0 (0 uses the global setting)!");
+
+    this->num_threads_learn = num_threads_learn;
+    this->num_threads_infer = num_threads_infer;
+}
+
+void Execution_Settings::run_pinned(
+    const std::function<void()> &f
+) const {
+    std::string error;
+
+    std::thread thread([&]() {
+        try {
+#ifdef __linux__
+            if (!cpus.empty()) {
+                cpu_set_t set;
+
+                make_cpu_set(cpus, set);
+
+                if (!pin_calling_thread(set))
+                    throw std::runtime_error("error: could not pin to the given cpus - are they online?");
+            }
+#endif
+
+            f();
+        }
+        catch (const std::exception &e) {
+            error = e.what();
+        }
+    });
+
+    thread.join();
+
+    if (!error.empty())
+        throw std::runtime_error(error);
+}
+
+Execution_Scope::Execution_Scope(
+    const Execution_Settings &settings,
+    bool learn_enabled
+)
+:
+prev_num_threads(0),
+pinned(false)
+{
+    int settings_num_threads = settings.get_num_threads(learn_enabled);
+
+    if (settings_num_threads > 0) {
+        prev_num_threads = aon::get_num_threads();
+
+        aon::set_num_threads(settings_num_threads);
+    }
+
+#ifdef __linux__
+    if (!settings.cpus.empty()) {
+        cpu_set_t set;
+
+        make_cpu_set(settings.cpus, set);
+
+        // every member of the team pins itself, the calling thread included
+        #pragma omp parallel
+        save_and_pin_calling_thread(set);
+
+        pinned = true;
+    }
+#endif
+}
+
+Execution_Scope::~Execution_Scope() {
+#ifdef __linux__
+    // same team size as when pinning, so the same threads restore themselves
+    if (pinned) {
+        #pragma omp parallel
+        restore_calling_thread();
+    }
+#endif
+
+    if (prev_num_threads > 0)
+        aon::set_num_threads(prev_num_threads);
+}
@@ -0,0 +1,80 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "py_helpers.h"
+
+#include <functional>
+
+namespace py = pybind11;
+
+namespace pyaon {
+// per-instance execution settings, applied around each step by Execution_Scope
+// thread counts of 0 keep the process-wide set_num_threads setting, empty cpus leave the affinity alone
+// learning and inference steps can use different thread counts (see Hierarchy::autotune)
+class Execution_Settings {
+private:
+    friend class Execution_Scope;
+
+    int num_threads_learn;
+    int num_threads_infer;
+    std::vector<int> cpus;
+
+public:
+    Execution_Settings()
+    :
+    num_threads_learn(0),
+    num_threads_infer(0)
+    {}
+
+    // sets both thread counts
+    void set(
+        int num_threads,
+        const std::vector<int> &cpus
+    );
+
+    void set_num_threads(
+        int num_threads_learn,
+        int num_threads_infer
+    );
+
+    int get_num_threads(
+        bool learn_enabled
+    ) const {
+        return (learn_enabled ? num_threads_learn : num_threads_infer);
+    }
+
+    const std::vector<int> &get_cpus() const {
+        return cpus;
+    }
+
+    // runs f on a temporary thread pinned to cpus, so memory first touched by f lands on their NUMA node
+    // does not touch Python objects, call with the GIL released
+    void run_pinned(
+        const std::function<void()> &f
+    ) const;
+};
+
+// applies the settings to the calling thread and its OpenMP team, the thread count and affinities are restored on exit
+// so a pinned instance does not leave the stepping thread (or its team) on its cpus for whatever runs there next
+// construct with the GIL released
+class Execution_Scope {
+private:
+    int prev_num_threads;
+    bool pinned;
+
+public:
+    Execution_Scope(
+        const Execution_Settings &settings,
+        bool learn_enabled
+    );
+
+    ~Execution_Scope();
+};
+}
@@ -8,7 +8,19 @@
 
 #include "py_helpers.h"
 
-#include <assert.h>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 using namespace pyaon;
 
@@ -20,22 +32,325 @@ void File_Writer::write(const void* data, long len) {
     outs.write(static_cast<const char*>(data), len);
 }
 
+Mapped_File::Mapped_File(const std::string &file_name, bool sequential)
+:
+data(nullptr),
+size(0)
+{
+#ifdef _WIN32
+    file_handle = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, (sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_ATTRIBUTE_NORMAL), nullptr);
+
+    if (file_handle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("error: could not open file " + file_name + "!");
+
+    LARGE_INTEGER file_size;
+
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file_handle);
+
+        throw std::runtime_error("error: file " + file_name + " is empty or its size could not be determined!");
+    }
+
+    size = file_size.QuadPart;
+
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+
+        throw std::runtime_error("error: could not map file " + file_name + "!");
+    }
+
+    data = static_cast<const unsigned char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+
+    if (data == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+
+        throw std::runtime_error("error: could not map file " + file_name + "!");
+    }
+#else
+    fd = open(file_name.c_str(), O_RDONLY);
+
+    if (fd == -1)
+        throw std::runtime_error("error: could not open file " + file_name + "!");
+
+    struct stat file_stat;
+
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size == 0) {
+        close(fd);
+
+        throw std::runtime_error("error: file " + file_name + " is empty or its size could not be determined!");
+    }
+
+    size = file_stat.st_size;
+
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (mapping == MAP_FAILED) {
+        close(fd);
+
+        throw std::runtime_error("error: could not map file " + file_name + "!");
+    }
+
+    // whole file is read front to back exactly once
+    if (sequential) {
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        madvise(mapping, size, MADV_WILLNEED);
+    }
+
+    data = static_cast<const unsigned char*>(mapping);
+#endif
+}
+
+Mapped_File::~Mapped_File() {
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+#else
+    munmap(const_cast<unsigned char*>(data), size);
+    close(fd);
+#endif
+}
+
+void Mapped_File_Reader::read(void* data, long len) {
+    if (start + len > file.get_size())
+        throw std::runtime_error("error: attempted to read past the end of the file (" + std::to_string(start + len) + " > " + std::to_string(file.get_size()) + " bytes) - is the file truncated?");
+
+    std::memcpy(data, file.get_data() + start, len);
+
+    start += len;
+}
+
+static void check_c_contiguous(const py::buffer_info &info) {
+    py::ssize_t stride = info.itemsize;
+
+    for (int d = info.ndim - 1; d >= 0; d--) {
+        if (info.shape[d] > 1 && info.strides[d] != stride)
+            throw std::runtime_error("error: buffer must be C-contiguous!");
+
+        stride *= info.shape[d];
+    }
+}
+
+long long pyaon::get_buffer_size(const py::buffer &buffer) {
+    py::buffer_info info = buffer.request();
+
+    return static_cast<long long>(info.size) * info.itemsize;
+}
+
+Buffer_Reader::Buffer_Reader(const py::buffer &buffer)
+:
+start(0),
+info(buffer.request())
+{
+    check_c_contiguous(info);
+
+    data = static_cast<const unsigned char*>(info.ptr);
+    size = static_cast<long long>(info.size) * info.itemsize;
+}
+
 void Buffer_Reader::read(void* data, long len) {
-    auto view = buffer->unchecked();
+    if (start + len > size)
+        throw std::runtime_error("error: attempted to read past the end of the buffer (" + std::to_string(start + len) + " > " + std::to_string(size) + " bytes) - is the buffer truncated?");
 
-    for (long i = 0; i < len; i++)
-        static_cast<unsigned char*>(data)[i] = view(start + i);
+    std::memcpy(data, this->data + start, len);
 
     start += len;
 }
 
 void Buffer_Writer::write(const void* data, long len) {
-    assert(buffer.size() >= start + len);
+    if (start + len > static_cast<long long>(buffer.size()))
+        throw std::runtime_error("error: attempted to write past the end of the buffer (" + std::to_string(start + len) + " > " + std::to_string(buffer.size()) + " bytes)!");
+
+    std::memcpy(this->data + start, data, len);
+
+    start += len;
+}
+
+Delta_Writer::Delta_Writer(const py::buffer &base)
+:
+base_info(base.request()),
+start(0),
+num_records(0),
+last_record_end(-1),
+last_record_pos(0)
+{
+    check_c_contiguous(base_info);
+
+    this->base = static_cast<const unsigned char*>(base_info.ptr);
+    base_size = base_info.size * base_info.itemsize;
+}
+
+void Delta_Writer::write(const void* data, long len) {
+    if (start + len > base_size)
+        throw std::runtime_error("error: state is larger than the base (" + std::to_string(start + len) + " > " + std::to_string(base_size) + " bytes) - was the base made by this hierarchy?");
+
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    for (long long offset = 0; offset < len; offset += delta_block_size) {
+        long long block_size = std::min<long long>(delta_block_size, len - offset);
+
+        if (std::memcmp(bytes + offset, base + start + offset, block_size) == 0)
+            continue;
+
+        long long position = start + offset;
 
-    auto view = buffer.mutable_unchecked();
+        if (position == last_record_end) {
+            // extend the previous record
+            long long record_len;
 
-    for (long i = 0; i < len; i++)
-        view[start + i] = static_cast<const unsigned char*>(data)[i];
+            std::memcpy(&record_len, &records[last_record_pos], sizeof(long long));
+
+            record_len += block_size;
+
+            std::memcpy(&records[last_record_pos], &record_len, sizeof(long long));
+        }
+        else {
+            records.insert(records.end(), reinterpret_cast<const unsigned char*>(&position), reinterpret_cast<const unsigned char*>(&position) + sizeof(long long));
+
+            last_record_pos = records.size();
+
+            records.insert(records.end(), reinterpret_cast<const unsigned char*>(&block_size), reinterpret_cast<const unsigned char*>(&block_size) + sizeof(long long));
+
+            num_records++;
+        }
+
+        records.insert(records.end(), bytes + offset, bytes + offset + block_size);
+
+        last_record_end = position + block_size;
+    }
 
     start += len;
 }
+
+py::array_t<unsigned char> Delta_Writer::finish() const {
+    if (start != base_size)
+        throw std::runtime_error("error: state size (" + std::to_string(start) + " bytes) does not match the base (" + std::to_string(base_size) + " bytes) - was the base made by this hierarchy?");
+
+    const long long header_size = 4 + 2 * sizeof(long long);
+
+    py::array_t<unsigned char> delta(header_size + records.size());
+
+    unsigned char* data = delta.mutable_data();
+
+    std::memcpy(data, "AOND", 4);
+    std::memcpy(data + 4, &base_size, sizeof(long long));
+    std::memcpy(data + 4 + sizeof(long long), &num_records, sizeof(long long));
+
+    if (!records.empty())
+        std::memcpy(data + header_size, records.data(), records.size());
+
+    return delta;
+}
+
+py::array_t<unsigned char> pyaon::apply_delta(
+    const py::buffer &base,
+    const py::buffer &delta
+) {
+    Buffer_Reader base_reader(base);
+    Buffer_Reader delta_reader(delta);
+
+    char magic[4];
+
+    delta_reader.read(magic, 4);
+
+    if (std::memcmp(magic, "AOND", 4) != 0)
+        throw std::runtime_error("error: not a state delta (bad magic)!");
+
+    long long base_size;
+    long long num_records;
+
+    delta_reader.read(&base_size, sizeof(long long));
+    delta_reader.read(&num_records, sizeof(long long));
+
+    if (base_size != base_reader.size)
+        throw std::runtime_error("error: delta was made against a base of " + std::to_string(base_size) + " bytes, but the given base has " + std::to_string(base_reader.size) + " bytes!");
+
+    py::array_t<unsigned char> result(base_size);
+
+    unsigned char* data = result.mutable_data();
+
+    if (base_size > 0)
+        std::memcpy(data, base_reader.data, base_size);
+
+    for (long long r = 0; r < num_records; r++) {
+        long long offset;
+        long long len;
+
+        delta_reader.read(&offset, sizeof(long long));
+        delta_reader.read(&len, sizeof(long long));
+
+        if (offset < 0 || len < 0 || offset + len > base_size)
+            throw std::runtime_error("error: delta record " + std::to_string(r) + " is out of bounds - is the delta corrupted?");
+
+        delta_reader.read(data + offset, len);
+    }
+
+    return result;
+}
+
+Step_Profiler::Step_Profiler(
+    const std::vector<std::string> &names
+)
+:
+enabled(false)
+{
+    sections.resize(names.size());
+
+    for (int i = 0; i < sections.size(); i++)
+        sections[i].name = names[i];
+
+    set_enabled(false, 1024);
+}
+
+void Step_Profiler::set_enabled(
+    bool enabled,
+    int window_size
+) {
+    if (window_size < 1)
+        throw std::runtime_error("error: window_size < 1 is not allowed!");
+
+    this->enabled = enabled;
+
+    for (int i = 0; i < sections.size(); i++)
+        sections[i].window.assign(enabled ? window_size : 1, 0.0);
+
+    reset();
+}
+
+void Step_Profiler::reset() {
+    for (int i = 0; i < sections.size(); i++) {
+        sections[i].count = 0;
+        sections[i].total = 0.0;
+        sections[i].last = 0.0;
+    }
+}
+
+py::dict Step_Profiler::get_profile() const {
+    py::dict profile;
+
+    for (int i = 0; i < sections.size(); i++) {
+        const Section &s = sections[i];
+
+        int window_count = std::min<long>(s.count, s.window.size());
+
+        std::vector<double> sorted(s.window.begin(), s.window.begin() + window_count);
+
+        std::sort(sorted.begin(), sorted.end());
+
+        py::dict section;
+
+        section["count"] = s.count;
+        section["total_ms"] = s.total * 1000.0;
+        section["mean_ms"] = (s.count > 0 ? s.total / s.count * 1000.0 : 0.0);
+        section["last_ms"] = s.last * 1000.0;
+        section["p50_ms"] = (window_count > 0 ? sorted[window_count / 2] * 1000.0 : 0.0);
+        section["p99_ms"] = (window_count > 0 ? sorted[std::min(window_count - 1, window_count * 99 / 100)] * 1000.0 : 0.0);
+
+        profile[s.name.c_str()] = section;
+    }
+
+    return profile;
+}
@@ -11,10 +11,14 @@
 #include <aogmaneo/helpers.h>
 #include <tuple>
 #include <string>
+#include <cstring>
+#include <cstdint>
+#include <chrono>
 #include <vector>
 #include <fstream>
 #include <iostream>
 #include <exception>
+#include <memory>
 
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -43,6 +47,166 @@ inline unsigned long get_global_state() {
     return aon::global_state;
 }
 
+// splitmix64, used for random streams owned by binding objects so they do not contend on aon::global_state
+inline std::uint64_t stream_rand(
+    std::uint64_t &state
+) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+    return z ^ (z >> 31);
+}
+
+// uniform in [0, 1)
+inline float stream_randf(
+    std::uint64_t &state
+) {
+    return (stream_rand(state) >> 40) * (1.0f / 16777216.0f);
+}
+
+// seed for a new binding-owned random stream, derived from aon::global_state without advancing it,
+// so creating such streams does not change the weights of anything initialized afterwards
+// a per-process counter keeps streams created under the same global state apart
+// only called with the GIL held
+inline std::uint64_t new_stream_seed() {
+    static std::uint64_t num_streams = 0;
+
+    std::uint64_t counter_state = num_streams++;
+
+    std::uint64_t state = static_cast<std::uint64_t>(aon::global_state) ^ stream_rand(counter_state);
+
+    return stream_rand(state);
+}
+
+// checks that all column indices are in [0, column_size)
+// written as a branchless min/max reduction so that it auto-vectorizes
+inline bool cis_in_range(
+    const int* cis,
+    long long count,
+    int column_size
+) {
+    int min_index = 0;
+    int max_index = 0;
+
+    for (long long j = 0; j < count; j++) {
+        min_index = aon::min(min_index, cis[j]);
+        max_index = aon::max(max_index, cis[j]);
+    }
+
+    return min_index >= 0 && max_index < column_size;
+}
+
+// base of objects that hand out copy = false views (see buffer_to_numpy)
+// counts the views still alive, so methods that reallocate the viewed buffers can refuse to run instead of leaving them dangling
+// the count is only touched with the GIL held
+class View_Owner {
+private:
+    std::shared_ptr<int> num_views;
+
+public:
+    View_Owner()
+    :
+    num_views(std::make_shared<int>(0))
+    {}
+
+    // views belong to the object they were taken from, not to copies of it
+    View_Owner(
+        const View_Owner &other
+    )
+    :
+    num_views(std::make_shared<int>(0))
+    {}
+
+    View_Owner &operator=(
+        const View_Owner &other
+    ) {
+        return *this;
+    }
+
+    int get_num_views() const {
+        return *num_views;
+    }
+
+    // throws if any view is alive, called before reallocating (or sharing) the buffers views may point into
+    void check_no_views(
+        const std::string &method
+    ) const {
+        if (*num_views > 0)
+            throw std::runtime_error("error: " + method + " reallocates or shares internal buffers, but " + std::to_string(*num_views) +
+                " copy=False view(s) of them are still alive - delete them (or take copies) first!");
+    }
+
+    // base object for a new view: keeps the owner alive and counts the view until numpy releases it
+    py::capsule new_view_base(
+        py::object owner
+    ) const {
+        struct View_Ref {
+            py::object owner;
+            std::shared_ptr<int> num_views;
+        };
+
+        View_Ref* ref = new View_Ref{ std::move(owner), num_views };
+
+        (*num_views)++;
+
+        return py::capsule(ref, [](void* p) {
+            View_Ref* ref = static_cast<View_Ref*>(p);
+
+            (*ref->num_views)--;
+
+            delete ref;
+        });
+    }
+};
+
+// converts an internal buffer to numpy in one of three ways:
+// - out is given: copies into the caller-supplied C-contiguous array of matching dtype and size, and returns it
+// - copy is true: copies into a newly allocated array
+// - copy is false: returns a read-only view onto the internal buffer, keeping the owning Python object alive
+//   the view reflects later steps, and the owner (a View_Owner) refuses to reallocate the buffer while the view is alive
+template<typename T, typename O>
+py::array_t<T> buffer_to_numpy(
+    const aon::Array<T> &buffer,
+    bool copy,
+    const py::object &out,
+    const O* owner
+) {
+    if (!out.is_none()) {
+        if (!py::isinstance<py::array_t<T, py::array::c_style>>(out))
+            throw std::runtime_error("error: out must be a C-contiguous numpy array of dtype " + std::string(py::str(py::dtype::of<T>())) + "!");
+
+        py::array_t<T> out_array = py::reinterpret_borrow<py::array_t<T>>(out);
+
+        if (out_array.size() != buffer.size())
+            throw std::runtime_error("error: out has size " + std::to_string(out_array.size()) + ", expected " + std::to_string(buffer.size()) + "!");
+
+        if (buffer.size() > 0)
+            std::memcpy(out_array.mutable_data(), &buffer[0], buffer.size() * sizeof(T));
+
+        return out_array;
+    }
+
+    if (!copy && buffer.size() > 0) {
+        py::capsule base = owner->new_view_base(py::cast(const_cast<O*>(owner), py::return_value_policy::reference));
+
+        py::array_t<T> view(buffer.size(), &buffer[0], base);
+
+        // clear the writeable flag, the buffer belongs to the owner
+        py::detail::array_proxy(view.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+
+        return view;
+    }
+
+    py::array_t<T> result(buffer.size());
+
+    if (buffer.size() > 0)
+        std::memcpy(result.mutable_data(), &buffer[0], buffer.size() * sizeof(T));
+
+    return result;
+}
+
 class File_Reader : public aon::Stream_Reader {
 public:
     std::ifstream ins;
@@ -63,15 +227,52 @@ public:
     ) override;
 };
 
-class Buffer_Reader : public aon::Stream_Reader {
+// read-only memory mapping of an entire file
+// sequential = true hints that the whole file is read front to back once, prefetching it
+class Mapped_File {
+private:
+    const unsigned char* data;
+    long long size;
+
+#ifdef _WIN32
+    void* file_handle;
+    void* mapping_handle;
+#else
+    int fd;
+#endif
+
+public:
+    Mapped_File(
+        const std::string &file_name,
+        bool sequential
+    );
+
+    ~Mapped_File();
+
+    Mapped_File(const Mapped_File&) = delete;
+    Mapped_File &operator=(const Mapped_File&) = delete;
+
+    const unsigned char* get_data() const {
+        return data;
+    }
+
+    long long get_size() const {
+        return size;
+    }
+};
+
+// reads straight out of a memory mapped file, avoiding the ifstream buffering copies
+class Mapped_File_Reader : public aon::Stream_Reader {
 public:
-    int start;
-    const py::array_t<unsigned char>* buffer;
+    long long start;
+    Mapped_File file;
 
-    Buffer_Reader()
+    Mapped_File_Reader(
+        const std::string &file_name
+    )
     :
     start(0),
-    buffer(nullptr)
+    file(file_name, true)
     {}
 
     void read(
@@ -80,17 +281,43 @@ public:
     ) override;
 };
 
+// size in bytes of any object exposing the buffer protocol
+long long get_buffer_size(
+    const py::buffer &buffer
+);
+
+// reads from any contiguous object exposing the buffer protocol (numpy arrays, bytes, memoryview, mmap)
+class Buffer_Reader : public aon::Stream_Reader {
+public:
+    long long start;
+
+    py::buffer_info info;
+    const unsigned char* data;
+    long long size;
+
+    Buffer_Reader(
+        const py::buffer &buffer
+    );
+
+    void read(
+        void* data,
+        long len
+    ) override;
+};
+
 class Buffer_Writer : public aon::Stream_Writer {
 public:
-    long start;
+    long long start;
     py::array_t<unsigned char> buffer;
+    unsigned char* data;
 
     Buffer_Writer(
-        long buffer_size
+        long long buffer_size
     )
     :
     start(0),
-    buffer(buffer_size)
+    buffer(buffer_size),
+    data(buffer.mutable_data())
     {}
 
     void write(
@@ -98,4 +325,173 @@ public:
         long len
     ) override;
 };
+
+// reads from raw memory, e.g. a section of a mapped file
+class Memory_Reader : public aon::Stream_Reader {
+public:
+    long long start;
+    const unsigned char* data;
+    long long size;
+
+    Memory_Reader(
+        const unsigned char* data,
+        long long size
+    )
+    :
+    start(0),
+    data(data),
+    size(size)
+    {}
+
+    void read(
+        void* data,
+        long len
+    ) override {
+        if (start + len > size)
+            throw std::runtime_error("error: attempted to read past the end of the data (" + std::to_string(start + len) + " > " + std::to_string(size) + " bytes) - is it truncated?");
+
+        std::memcpy(data, this->data + start, len);
+
+        start += len;
+    }
+};
+
+// writes into a std::vector, for snapshots that outlive the GIL (e.g. handed to a background thread)
+class Vector_Writer : public aon::Stream_Writer {
+public:
+    std::vector<unsigned char> buffer;
+
+    Vector_Writer(
+        long long reserve_size
+    ) {
+        buffer.reserve(reserve_size);
+    }
+
+    void write(
+        const void* data,
+        long len
+    ) override {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+        buffer.insert(buffer.end(), bytes, bytes + len);
+    }
+};
+
+class Vector_Reader : public aon::Stream_Reader {
+public:
+    long long start;
+    const std::vector<unsigned char> &buffer;
+
+    Vector_Reader(
+        const std::vector<unsigned char> &buffer
+    )
+    :
+    start(0),
+    buffer(buffer)
+    {}
+
+    void read(
+        void* data,
+        long len
+    ) override {
+        if (start + len > buffer.size())
+            throw std::runtime_error("error: attempted to read past the end of the buffer!");
+
+        std::memcpy(data, buffer.data() + start, len);
+
+        start += len;
+    }
+};
+
+// writes only the byte ranges that differ from a base stream of the same layout, for delta checkpoints
+// the base is compared in blocks of delta_block_size bytes, changed blocks are stored as (offset, length, bytes) records
+// layout: "AOND", int64 base size, int64 number of records, records
+class Delta_Writer : public aon::Stream_Writer {
+private:
+    py::buffer_info base_info;
+    const unsigned char* base;
+    long long base_size;
+
+    long long start;
+
+    std::vector<unsigned char> records;
+    long long num_records;
+    long long last_record_end;
+    long long last_record_pos; // position of the last record's length field in records
+
+public:
+    static const int delta_block_size = 16;
+
+    Delta_Writer(
+        const py::buffer &base
+    );
+
+    void write(
+        const void* data,
+        long len
+    ) override;
+
+    // checks the whole base was covered and returns the delta
+    py::array_t<unsigned char> finish() const;
+};
+
+// reconstructs the full stream from a base and a delta made by Delta_Writer
+py::array_t<unsigned char> apply_delta(
+    const py::buffer &base,
+    const py::buffer &delta
+);
+
+// opt-in coarse wall time breakdown of steps into a few named sections
+// keeps running totals, and a window of the most recent samples for percentiles
+// recording does not touch Python objects, so it may happen with the GIL released
+class Step_Profiler {
+private:
+    struct Section {
+        std::string name;
+        std::vector<double> window; // ring buffer of recent samples, in seconds
+        long count;
+        double total;
+        double last;
+    };
+
+    std::vector<Section> sections;
+
+    bool enabled;
+
+public:
+    Step_Profiler(
+        const std::vector<std::string> &names
+    );
+
+    static double now() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    bool is_enabled() const {
+        return enabled;
+    }
+
+    // enabling also clears previous samples
+    void set_enabled(
+        bool enabled,
+        int window_size
+    );
+
+    void reset();
+
+    void add(
+        int section,
+        double seconds
+    ) {
+        Section &s = sections[section];
+
+        s.window[s.count % s.window.size()] = seconds;
+        s.count++;
+        s.total += seconds;
+        s.last = seconds;
+    }
+
+    // dict of section name -> dict of count, total_ms, mean_ms, last_ms, p50_ms, p99_ms (percentiles over the window)
+    py::dict get_profile() const;
+};
 }
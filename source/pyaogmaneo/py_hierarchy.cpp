@@ -7,9 +7,623 @@
 // ----------------------------------------------------------------------------
 
 #include "py_hierarchy.h"
+#include "py_compression.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <thread>
 
 using namespace pyaon;
 
+namespace {
+// meta section of indexed files: int32 number of IOs, per IO int32 size x, y, z and type,
+// int32 number of layers, per layer int32 hidden size x, y, z,
+// then per layer int32 number of encoder visible layers, per visible layer int32 size x, y, z, radius and
+// int64 offset of its weights in the "enc<l>" section (-1 if not known), absent in files written before it was added
+void write_meta(
+    aon::Hierarchy &h,
+    const std::vector<std::vector<long long>> &weights_offsets,
+    Vector_Writer &writer
+) {
+    std::vector<std::int32_t> values;
+
+    values.push_back(h.get_num_io());
+
+    for (int i = 0; i < h.get_num_io(); i++) {
+        aon::Int3 size = h.get_io_size(i);
+
+        values.push_back(size.x);
+        values.push_back(size.y);
+        values.push_back(size.z);
+        values.push_back(h.get_io_type(i));
+    }
+
+    values.push_back(h.get_num_layers());
+
+    for (int l = 0; l < h.get_num_layers(); l++) {
+        aon::Int3 size = h.get_encoder(l).get_hidden_size();
+
+        values.push_back(size.x);
+        values.push_back(size.y);
+        values.push_back(size.z);
+    }
+
+    writer.write(values.data(), values.size() * sizeof(std::int32_t));
+
+    for (int l = 0; l < h.get_num_layers(); l++) {
+        const aon::Encoder &enc = h.get_encoder(l);
+
+        std::int32_t num_visible_layers = enc.get_num_visible_layers();
+
+        writer.write(&num_visible_layers, sizeof(std::int32_t));
+
+        for (int vli = 0; vli < num_visible_layers; vli++) {
+            const aon::Encoder::Visible_Layer_Desc &vld = enc.get_visible_layer_desc(vli);
+
+            std::int32_t layout[4] = { vld.size.x, vld.size.y, vld.size.z, vld.radius };
+
+            std::int64_t offset = (l < weights_offsets.size() ? weights_offsets[l][vli] : -1);
+
+            writer.write(layout, sizeof(layout));
+            writer.write(&offset, sizeof(std::int64_t));
+        }
+    }
+}
+
+Hierarchy_Meta read_meta(
+    const unsigned char* data,
+    const Container_Section &section
+) {
+    Memory_Reader reader(data + section.offset, section.size);
+
+    Hierarchy_Meta meta;
+
+    std::int32_t num_io;
+
+    reader.read(&num_io, sizeof(std::int32_t));
+
+    // bounded by the section size, so a corrupted count cannot allocate much
+    if (num_io < 0 || num_io > section.size / 16)
+        throw std::runtime_error("error: corrupted meta section (" + std::to_string(num_io) + " IOs)!");
+
+    for (int i = 0; i < num_io; i++) {
+        std::int32_t values[4];
+
+        reader.read(values, sizeof(values));
+
+        meta.io_sizes.push_back(aon::Int3(values[0], values[1], values[2]));
+        meta.io_types.push_back(values[3]);
+    }
+
+    std::int32_t num_layers;
+
+    reader.read(&num_layers, sizeof(std::int32_t));
+
+    if (num_layers < 0 || num_layers > section.size / 12)
+        throw std::runtime_error("error: corrupted meta section (" + std::to_string(num_layers) + " layers)!");
+
+    for (int l = 0; l < num_layers; l++) {
+        std::int32_t values[3];
+
+        reader.read(values, sizeof(values));
+
+        meta.hidden_sizes.push_back(aon::Int3(values[0], values[1], values[2]));
+    }
+
+    if (reader.start == section.size)
+        return meta;
+
+    meta.encoder_layouts.resize(num_layers);
+
+    for (int l = 0; l < num_layers; l++) {
+        std::int32_t num_visible_layers;
+
+        reader.read(&num_visible_layers, sizeof(std::int32_t));
+
+        if (num_visible_layers < 0 || num_visible_layers > section.size / 24)
+            throw std::runtime_error("error: corrupted meta section (" + std::to_string(num_visible_layers) + " visible layers)!");
+
+        for (int vli = 0; vli < num_visible_layers; vli++) {
+            std::int32_t layout[4];
+            std::int64_t offset;
+
+            reader.read(layout, sizeof(layout));
+            reader.read(&offset, sizeof(std::int64_t));
+
+            Encoder_Visible_Layout visible_layout;
+
+            visible_layout.size = aon::Int3(layout[0], layout[1], layout[2]);
+            visible_layout.radius = layout[3];
+            visible_layout.weights_offset = offset;
+
+            meta.encoder_layouts[l].push_back(visible_layout);
+        }
+    }
+
+    return meta;
+}
+
+// remembers the source and output offset of every write without keeping the bytes, so arrays can be found in the output
+class Address_Writer : public aon::Stream_Writer {
+public:
+    struct Write {
+        const void* data;
+        long len;
+        long long offset;
+    };
+
+    std::vector<Write> writes;
+    long long size;
+
+    Address_Writer()
+    :
+    size(0)
+    {}
+
+    void write(
+        const void* data,
+        long len
+    ) override {
+        Write w = { data, len, size };
+
+        writes.push_back(w);
+
+        size += len;
+    }
+};
+
+// Address_Writer that also keeps the bytes
+class Recording_Writer : public Address_Writer {
+public:
+    std::vector<unsigned char> buffer;
+
+    Recording_Writer(
+        long long reserve_size
+    ) {
+        buffer.reserve(reserve_size);
+    }
+
+    void write(
+        const void* data,
+        long len
+    ) override {
+        Address_Writer::write(data, len);
+
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+        buffer.insert(buffer.end(), bytes, bytes + len);
+    }
+};
+
+// writes of at least this size are taken to be arrays, smaller ones may come from temporaries whose addresses get reused
+const long min_masked_write_size = 64;
+
+// struct section of indexed files: the full model stream, with the arrays also written by write_weights and write_state
+// replaced by zero runs, since their sections overwrite them anyway
+// layout: repeated records of int64 literal length, int64 zero run length, then the literal bytes
+class Struct_Writer : public aon::Stream_Writer {
+public:
+    std::vector<unsigned char> buffer;
+
+    std::map<const void*, long> masked;
+
+    long long record_start;
+    std::int64_t literal_size;
+    std::int64_t zeros_size;
+
+    Struct_Writer()
+    :
+    record_start(-1),
+    literal_size(0),
+    zeros_size(0)
+    {}
+
+    // every recorded write that is large enough
+    void mask(
+        const Address_Writer &recorded
+    ) {
+        for (int w = 0; w < recorded.writes.size(); w++) {
+            if (recorded.writes[w].len >= min_masked_write_size)
+                masked[recorded.writes[w].data] = recorded.writes[w].len;
+        }
+    }
+
+    void write(
+        const void* data,
+        long len
+    ) override {
+        std::map<const void*, long>::const_iterator it = masked.find(data);
+
+        bool zeros = (it != masked.end() && it->second == len);
+
+        // literal bytes after a zero run start a new record
+        if (record_start == -1 || (!zeros && zeros_size > 0)) {
+            record_start = buffer.size();
+            literal_size = 0;
+            zeros_size = 0;
+
+            buffer.resize(buffer.size() + 2 * sizeof(std::int64_t));
+        }
+
+        if (zeros)
+            zeros_size += len;
+        else {
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+            buffer.insert(buffer.end(), bytes, bytes + len);
+
+            literal_size += len;
+        }
+
+        std::memcpy(&buffer[record_start], &literal_size, sizeof(std::int64_t));
+        std::memcpy(&buffer[record_start + sizeof(std::int64_t)], &zeros_size, sizeof(std::int64_t));
+    }
+};
+
+// expands a struct section while reading it, so the zero runs are never materialized
+class Struct_Reader : public aon::Stream_Reader {
+public:
+    const unsigned char* data;
+    long long size;
+    long long start;
+
+    std::int64_t literal_left;
+    std::int64_t zeros_left;
+
+    Struct_Reader(
+        const unsigned char* data,
+        long long size
+    )
+    :
+    data(data),
+    size(size),
+    start(0),
+    literal_left(0),
+    zeros_left(0)
+    {}
+
+    void read(
+        void* data,
+        long len
+    ) override {
+        unsigned char* bytes = static_cast<unsigned char*>(data);
+
+        while (len > 0) {
+            if (literal_left == 0 && zeros_left == 0) {
+                if (start + 2 * static_cast<long long>(sizeof(std::int64_t)) > size)
+                    throw std::runtime_error("error: struct section is truncated!");
+
+                std::memcpy(&literal_left, this->data + start, sizeof(std::int64_t));
+                std::memcpy(&zeros_left, this->data + start + sizeof(std::int64_t), sizeof(std::int64_t));
+
+                start += 2 * sizeof(std::int64_t);
+
+                if (literal_left < 0 || zeros_left < 0 || literal_left > size - start)
+                    throw std::runtime_error("error: corrupted struct section!");
+
+                continue;
+            }
+
+            if (literal_left > 0) {
+                long n = static_cast<long>(std::min<long long>(len, literal_left));
+
+                std::memcpy(bytes, this->data + start, n);
+
+                start += n;
+                literal_left -= n;
+                bytes += n;
+                len -= n;
+            }
+            else {
+                long n = static_cast<long>(std::min<long long>(len, zeros_left));
+
+                std::memset(bytes, 0, n);
+
+                zeros_left -= n;
+                bytes += n;
+                len -= n;
+            }
+        }
+    }
+};
+
+// receptive field of one hidden cell over one encoder visible layer, from its weights array
+std::tuple<py::array_t<unsigned char>, std::tuple<int, int, int>> encoder_receptive_field(
+    const aon::Int3 &hidden_size,
+    const aon::Int3 &visible_size,
+    int radius,
+    const unsigned char* weights,
+    long long num_weights,
+    const std::tuple<int, int, int> &pos
+) {
+    if (std::get<0>(pos) < 0 || std::get<0>(pos) >= hidden_size.x ||
+        std::get<1>(pos) < 0 || std::get<1>(pos) >= hidden_size.y ||
+        std::get<2>(pos) < 0 || std::get<2>(pos) >= hidden_size.z) {
+        throw std::runtime_error("position (" + std::to_string(std::get<0>(pos)) + ", " + std::to_string(std::get<1>(pos)) + ", " + std::to_string(std::get<2>(pos)) + ") " +
+                + " not in size (" + std::to_string(hidden_size.x) + ", " + std::to_string(hidden_size.y) + ", " + std::to_string(hidden_size.z) + ")!");
+    }
+
+    int diam = radius * 2 + 1;
+    int area = diam * diam;
+
+    aon::Int2 column_pos(std::get<0>(pos), std::get<1>(pos));
+
+    int hidden_column_index = aon::address2(column_pos, aon::Int2(hidden_size.x, hidden_size.y));
+
+    // projection
+    aon::Float2 h_to_v = aon::Float2(static_cast<float>(visible_size.x) / static_cast<float>(hidden_size.x),
+            static_cast<float>(visible_size.y) / static_cast<float>(hidden_size.y));
+
+    aon::Int2 visible_center = project(column_pos, h_to_v);
+
+        // lower corner
+    aon::Int2 field_lower_bound(visible_center.x - radius, visible_center.y - radius);
+
+        // bounds of receptive field, clamped to input size
+    aon::Int2 iter_lower_bound(aon::max(0, field_lower_bound.x), aon::max(0, field_lower_bound.y));
+    aon::Int2 iter_upper_bound(aon::min(visible_size.x - 1, visible_center.x + radius), aon::min(visible_size.y - 1, visible_center.y + radius));
+
+    int field_count = area * visible_size.z;
+
+    py::array_t<unsigned char> field(field_count);
+
+    auto view = field.mutable_unchecked();
+
+    // first clear
+    for (int i = 0; i < field_count; i++)
+        view(i) = 0;
+
+    for (int ix = iter_lower_bound.x; ix <= iter_upper_bound.x; ix++)
+        for (int iy = iter_lower_bound.y; iy <= iter_upper_bound.y; iy++) {
+            aon::Int2 offset(ix - field_lower_bound.x, iy - field_lower_bound.y);
+
+            for (int vc = 0; vc < visible_size.z; vc++) {
+                // computed in 64 bits, the arrays themselves stay below 2^31 entries since init_random checks them
+                long long wi = std::get<2>(pos) + hidden_size.z * (offset.y + diam * (offset.x + diam * (vc + visible_size.z * static_cast<long long>(hidden_column_index))));
+
+                if (wi >= num_weights)
+                    throw std::runtime_error("error: receptive field index " + std::to_string(wi) + " is past the " + std::to_string(num_weights) + " weights of this visible layer!");
+
+                view(vc + visible_size.z * (offset.y + diam * offset.x)) = weights[wi];
+            }
+        }
+
+    std::tuple<int, int, int> field_size(diam, diam, visible_size.z);
+
+    return std::make_tuple(field, field_size);
+}
+
+// the weights of indexed files are split into one section per encoder ("enc<l>"), first layer decoder ("dec0_<i>" per prediction IO)
+// or actor ("act<i>" per action IO), and higher layer decoder ("dec<l>"), so parts can be loaded on their own
+// empty (a single "weights" section) if the names do not fit or the parts do not cover the weights
+enum Part_Type {
+    part_encoder = 0,
+    part_decoder = 1,
+    part_actor = 2
+};
+
+struct Weights_Part {
+    std::string name;
+    Part_Type type;
+    int l;
+    int i; // IO index for first layer decoders and actors
+};
+
+long long get_part_weights_size(
+    aon::Hierarchy &h,
+    const Weights_Part &part
+) {
+    switch (part.type) {
+    case part_encoder:
+        return h.get_encoder(part.l).weights_size();
+    case part_decoder:
+        return h.get_decoder(part.l, part.i).weights_size();
+    default:
+        return h.get_actor(part.i).weights_size();
+    }
+}
+
+void write_part_weights(
+    aon::Hierarchy &h,
+    const Weights_Part &part,
+    aon::Stream_Writer &writer
+) {
+    switch (part.type) {
+    case part_encoder:
+        h.get_encoder(part.l).write_weights(writer);
+        break;
+    case part_decoder:
+        h.get_decoder(part.l, part.i).write_weights(writer);
+        break;
+    default:
+        h.get_actor(part.i).write_weights(writer);
+    }
+}
+
+void read_part_weights(
+    aon::Hierarchy &h,
+    const Weights_Part &part,
+    aon::Stream_Reader &reader
+) {
+    switch (part.type) {
+    case part_encoder:
+        h.get_encoder(part.l).read_weights(reader);
+        break;
+    case part_decoder:
+        h.get_decoder(part.l, part.i).read_weights(reader);
+        break;
+    default:
+        h.get_actor(part.i).read_weights(reader);
+    }
+}
+
+std::vector<Weights_Part> get_weights_parts(
+    aon::Hierarchy &h
+) {
+    std::vector<Weights_Part> parts;
+
+    for (int l = 0; l < h.get_num_layers(); l++) {
+        Weights_Part part = { "enc" + std::to_string(l), part_encoder, l, -1 };
+
+        parts.push_back(part);
+
+        if (l == 0) {
+            for (int i = 0; i < h.get_num_io(); i++) {
+                if (!h.io_layer_exists(i))
+                    continue;
+
+                // action IOs have actors, not decoders, see get_down_radius
+                if (h.get_io_type(i) == aon::prediction) {
+                    Weights_Part io_part = { "dec0_" + std::to_string(i), part_decoder, l, i };
+
+                    parts.push_back(io_part);
+                }
+                else if (h.get_io_type(i) == aon::action) {
+                    Weights_Part io_part = { "act" + std::to_string(i), part_actor, l, i };
+
+                    parts.push_back(io_part);
+                }
+            }
+        }
+        else {
+            Weights_Part layer_part = { "dec" + std::to_string(l), part_decoder, l, 0 };
+
+            parts.push_back(layer_part);
+        }
+    }
+
+    long long total_size = 0;
+
+    for (int p = 0; p < parts.size(); p++) {
+        if (parts[p].name.size() > 8)
+            return std::vector<Weights_Part>();
+
+        total_size += get_part_weights_size(h, parts[p]);
+    }
+
+    if (total_size != h.weights_size())
+        return std::vector<Weights_Part>();
+
+    return parts;
+}
+
+// checks and (if needed) decompresses a section, expected_size >= 0 is checked before reading, so a mismatch writes nothing
+// does not touch Python objects
+template<typename F>
+void read_section(
+    const unsigned char* data,
+    const Container_Section &section,
+    long long expected_size,
+    F read
+) {
+    verify_section(data, section);
+
+    const unsigned char* section_data = data + section.offset;
+    long long size = section.size;
+
+    std::vector<unsigned char> raw;
+
+    if (is_compressed(section_data, size)) {
+        raw.resize(get_decompressed_size(section_data, size));
+
+        decompress_to(section_data, size, raw.data());
+
+        section_data = raw.data();
+        size = raw.size();
+    }
+
+    if (expected_size >= 0 && size != expected_size)
+        throw std::runtime_error("error: container section \"" + section.name + "\" has " + std::to_string(size) + " bytes, expected " + std::to_string(expected_size) + " - was it saved from a hierarchy of another structure?");
+
+    Memory_Reader reader(section_data, size);
+
+    read(reader);
+}
+
+// reads the named weights and state sections into h, which must have the structure they were saved from
+void read_named_sections(
+    aon::Hierarchy &h,
+    const unsigned char* data,
+    const std::vector<Container_Section> &sections,
+    const std::vector<std::string> &names
+) {
+    std::vector<Weights_Part> parts = get_weights_parts(h);
+
+    for (int n = 0; n < names.size(); n++) {
+        const Container_Section &section = find_section(sections, names[n]);
+
+        if (names[n] == "state") {
+            read_section(data, section, h.state_size(), [&h](aon::Stream_Reader &reader) {
+                h.read_state(reader);
+            });
+
+            continue;
+        }
+
+        if (names[n] == "weights") {
+            read_section(data, section, h.weights_size(), [&h](aon::Stream_Reader &reader) {
+                h.read_weights(reader);
+            });
+
+            continue;
+        }
+
+        int p = 0;
+
+        while (p < parts.size() && parts[p].name != names[n])
+            p++;
+
+        if (p == parts.size())
+            throw std::runtime_error("error: \"" + names[n] + "\" is not a weights or state section of this hierarchy!");
+
+        read_section(data, section, get_part_weights_size(h, parts[p]), [&h, &parts, p](aon::Stream_Reader &reader) {
+            read_part_weights(h, parts[p], reader);
+        });
+    }
+}
+
+// reads the whole model from a sectioned file ("struct" plus every weights and state section), or from the single "model" section of older files
+// the zero runs of the struct section are expanded while reading, so the only full size allocation is the model itself
+void read_all_sections(
+    aon::Hierarchy &h,
+    const unsigned char* data,
+    const std::vector<Container_Section> &sections
+) {
+    bool has_struct = false;
+
+    for (int s = 0; s < sections.size(); s++) {
+        if (sections[s].name == "struct")
+            has_struct = true;
+    }
+
+    if (!has_struct) {
+        read_section(data, find_section(sections, "model"), -1, [&h](aon::Stream_Reader &reader) {
+            h.read(reader);
+        });
+
+        return;
+    }
+
+    const Container_Section &struct_section = find_section(sections, "struct");
+
+    verify_section(data, struct_section);
+
+    Struct_Reader reader(data + struct_section.offset, struct_section.size);
+
+    h.read(reader);
+
+    std::vector<std::string> names;
+
+    for (int s = 0; s < sections.size(); s++) {
+        if (sections[s].name != "meta" && sections[s].name != "struct")
+            names.push_back(sections[s].name);
+    }
+
+    read_named_sections(h, data, sections, names);
+}
+}
+
 void IO_Desc::check_in_range() const {
     if (std::get<0>(size) < 1)
         throw std::runtime_error("error: size[0] < 1 is not allowed!");
@@ -62,13 +676,96 @@ void Layer_Desc::check_in_range() const {
         throw std::runtime_error("error: down_radius < 0 is not allowed!");
 }
 
+void pyaon::copy_params(
+    const aon::Hierarchy::Params &src,
+    aon::Hierarchy::Params &dst
+) {
+    if (src.ios.size() != dst.ios.size())
+        throw std::runtime_error("ios parameter size mismatch - did you modify the length of params.ios?");
+
+    if (src.layers.size() != dst.layers.size())
+        throw std::runtime_error("layers parameter size mismatch - did you modify the length of params.layers?");
+
+    for (int i = 0; i < src.ios.size(); i++)
+        dst.ios[i] = src.ios[i];
+
+    for (int l = 0; l < src.layers.size(); l++)
+        dst.layers[l] = src.layers[l];
+
+    dst.anticipation = src.anticipation;
+}
+
+py::list pyaon::get_params_layers(
+    const py::object &params
+) {
+    aon::Hierarchy::Params &p = params.cast<aon::Hierarchy::Params&>();
+
+    py::list layers;
+
+    for (int l = 0; l < p.layers.size(); l++)
+        layers.append(py::cast(&p.layers[l], py::return_value_policy::reference_internal, params));
+
+    return layers;
+}
+
+void pyaon::set_params_layers(
+    aon::Hierarchy::Params &params,
+    const std::vector<aon::Hierarchy::Layer_Params> &layers
+) {
+    if (params.layers.size() > 0 && layers.size() != params.layers.size())
+        throw std::runtime_error("layers parameter size mismatch - did you modify the length of params.layers?");
+
+    // only a fresh (empty) params object is sized, otherwise element-wise, so references from get_params_layers stay valid
+    if (params.layers.size() == 0)
+        params.layers.resize(layers.size());
+
+    for (int l = 0; l < layers.size(); l++)
+        params.layers[l] = layers[l];
+}
+
+py::list pyaon::get_params_ios(
+    const py::object &params
+) {
+    aon::Hierarchy::Params &p = params.cast<aon::Hierarchy::Params&>();
+
+    py::list ios;
+
+    for (int i = 0; i < p.ios.size(); i++)
+        ios.append(py::cast(&p.ios[i], py::return_value_policy::reference_internal, params));
+
+    return ios;
+}
+
+void pyaon::set_params_ios(
+    aon::Hierarchy::Params &params,
+    const std::vector<aon::Hierarchy::IO_Params> &ios
+) {
+    if (params.ios.size() > 0 && ios.size() != params.ios.size())
+        throw std::runtime_error("ios parameter size mismatch - did you modify the length of params.ios?");
+
+    // see set_params_layers
+    if (params.ios.size() == 0)
+        params.ios.resize(ios.size());
+
+    for (int i = 0; i < ios.size(); i++)
+        params.ios[i] = ios[i];
+}
+
 Hierarchy::Hierarchy(
     const std::vector<IO_Desc> &io_descs,
     const std::vector<Layer_Desc> &layer_descs,
     const std::string &file_name,
-    const py::array_t<unsigned char> &buffer
-) {
-    if (buffer.unchecked().size() > 0)
+    const py::buffer &buffer
+)
+:
+h(new aon::Hierarchy()),
+profiler({ "inputs", "core_step", "outputs", "total" }),
+fork_parent(nullptr),
+active(this),
+frozen(false),
+busy(false)
+{
+    if (get_buffer_size(buffer) > 0)
         init_from_buffer(buffer);
     else if (!file_name.empty())
         init_from_file(file_name);
@@ -76,223 +773,1255 @@ Hierarchy::Hierarchy(
         if (io_descs.empty() || layer_descs.empty())
             throw std::runtime_error("error: Hierarchy constructor requires some non-empty arguments!");
 
-        init_random(io_descs, layer_descs);
+        init_random(io_descs, layer_descs);
+    }
+
+    // indexed files already sized c_input_cis from their meta, without loading the model, and set the params once loaded
+    if (pending_file == nullptr) {
+        c_input_cis.resize(h->get_num_io());
+
+        instance_params = h->params;
+    }
+
+    // seed from the global state so set_global_state before construction stays reproducible
+    sample_state = new_stream_seed();
+}
+
+Hierarchy::Hierarchy()
+:
+h(new aon::Hierarchy()),
+profiler({ "inputs", "core_step", "outputs", "total" }),
+fork_parent(nullptr),
+active(this),
+frozen(false),
+busy(false)
+{}
+
+Hierarchy::Hierarchy(
+    const Hierarchy &other
+)
+:
+h(new aon::Hierarchy(other.model())),
+profiler({ "inputs", "core_step", "outputs", "total" }),
+fork_parent(nullptr),
+active(this),
+frozen(false),
+busy(false)
+{
+    instance_params = other.own_params();
+
+    c_input_cis.resize(h->get_num_io());
+
+    sample_state = other.sample_state;
+
+    execution = other.execution;
+}
+
+Hierarchy::~Hierarchy() {
+    if (fork_parent != nullptr)
+        fork_parent->release_fork(this);
+    else
+        materialize_forks();
+}
+
+std::unique_ptr<Hierarchy> Hierarchy::new_fork(
+    std::vector<unsigned char> &&state
+) const {
+    Hierarchy* owner = root();
+
+    std::unique_ptr<Hierarchy> f(new Hierarchy());
+
+    f->parked_state = std::move(state);
+    f->fork_parent = owner;
+    f->fork_parent_ref = py::cast(owner, py::return_value_policy::reference);
+    f->active = nullptr;
+
+    f->c_input_cis.resize(owner->h->get_num_io());
+
+    f->instance_params = own_params();
+
+    f->execution = execution;
+
+    // forks sample independently of each other
+    stream_rand(sample_state);
+
+    f->sample_state = sample_state;
+
+    owner->forks.push_back(f.get());
+
+    return f;
+}
+
+std::unique_ptr<Hierarchy> Hierarchy::fork() const {
+    check_no_model_views("fork");
+
+    aon::Hierarchy &m = model();
+
+    Vector_Writer writer(m.state_size());
+
+    m.write_state(writer);
+
+    return new_fork(std::move(writer.buffer));
+}
+
+void Hierarchy::set_frozen(
+    bool frozen
+) {
+    Hierarchy* owner = root();
+
+    if (frozen == owner->frozen)
+        return;
+
+    owner->frozen = frozen;
+
+    if (!frozen) {
+        owner->session_state = std::vector<unsigned char>();
+
+        return;
+    }
+
+    // capture the cleared state once, so sessions are created without touching the model
+    aon::Hierarchy &m = model();
+
+    Vector_Writer current(m.state_size());
+
+    m.write_state(current);
+
+    m.clear_state();
+
+    Vector_Writer cleared(m.state_size());
+
+    m.write_state(cleared);
+
+    owner->session_state = std::move(cleared.buffer);
+
+    Vector_Reader reader(current.buffer);
+
+    m.read_state(reader);
+}
+
+std::unique_ptr<Hierarchy> Hierarchy::create_session() const {
+    check_no_model_views("create_session");
+
+    Hierarchy* owner = root();
+
+    if (!owner->frozen)
+        throw std::runtime_error("error: sessions require frozen weights, call set_frozen(True) first!");
+
+    return new_fork(std::vector<unsigned char>(owner->session_state));
+}
+
+void Hierarchy::materialize() {
+    if (fork_parent == nullptr)
+        return;
+
+    Hierarchy* owner = fork_parent;
+
+    h.reset(new aon::Hierarchy(model()));
+
+    owner->release_fork(this);
+
+    fork_parent = nullptr;
+    active = this;
+
+    parked_state = std::vector<unsigned char>();
+
+    // may release the last reference to the root, so done last
+    fork_parent_ref = py::object();
+}
+
+void Hierarchy::materialize_forks() {
+    while (!forks.empty())
+        forks.back()->materialize();
+}
+
+void Hierarchy::wait_idle() {
+    while (busy) {
+        py::gil_scoped_release release;
+
+        std::unique_lock<std::mutex> lock(busy_mutex);
+
+        busy_cond.wait(lock, [this]() { return !busy; });
+    }
+}
+
+int Hierarchy::get_num_model_views() const {
+    Hierarchy* owner = root();
+
+    int num_views = owner->get_num_views();
+
+    for (int f = 0; f < owner->forks.size(); f++)
+        num_views += owner->forks[f]->get_num_views();
+
+    return num_views;
+}
+
+void Hierarchy::check_no_model_views(
+    const std::string &method
+) const {
+    Hierarchy* owner = root();
+
+    owner->check_no_views(method);
+
+    for (int f = 0; f < owner->forks.size(); f++)
+        owner->forks[f]->check_no_views(method);
+}
+
+void Hierarchy::check_view_allowed(
+    bool copy,
+    const py::object &out
+) const {
+    if (copy || !out.is_none())
+        return;
+
+    if (fork_parent != nullptr || !root()->forks.empty())
+        throw std::runtime_error("error: copy=False views are not available while the model is shared with forks or sessions, "
+            "its buffers hold the state of whichever instance was used last - use copy=True or out!");
+}
+
+void Hierarchy::swap_params() {
+    aon::Hierarchy::Params &shared = root()->h->params;
+
+    for (int i = 0; i < shared.ios.size(); i++)
+        std::swap(shared.ios[i], instance_params.ios[i]);
+
+    for (int l = 0; l < shared.layers.size(); l++)
+        std::swap(shared.layers[l], instance_params.layers[l]);
+
+    std::swap(shared.anticipation, instance_params.anticipation);
+}
+
+void Hierarchy::swap_state_in(
+    Hierarchy* next
+) {
+    // park the active state, reusing the capacity left over from its last swap
+    Vector_Writer writer(0);
+
+    writer.buffer.swap(active->parked_state);
+
+    h->write_state(writer);
+
+    writer.buffer.swap(active->parked_state);
+
+    Vector_Reader reader(next->parked_state);
+
+    h->read_state(reader);
+
+    next->parked_state.clear();
+
+    active = next;
+}
+
+void Hierarchy::release_fork(
+    Hierarchy* fork
+) {
+    for (int i = 0; i < forks.size(); i++) {
+        if (forks[i] == fork) {
+            forks.erase(forks.begin() + i);
+
+            break;
+        }
+    }
+
+    if (active == fork) {
+        Vector_Reader reader(parked_state);
+
+        h->read_state(reader);
+
+        parked_state.clear();
+
+        active = this;
+    }
+}
+
+void Hierarchy::init_random(
+    const std::vector<IO_Desc> &io_descs,
+    const std::vector<Layer_Desc> &layer_descs
+) {
+    aon::Array<aon::Hierarchy::IO_Desc> c_io_descs(io_descs.size());
+
+    for (int i = 0; i < io_descs.size(); i++) {
+        io_descs[i].check_in_range();
+
+        c_io_descs[i] = aon::Hierarchy::IO_Desc(
+            aon::Int3(std::get<0>(io_descs[i].size), std::get<1>(io_descs[i].size), std::get<2>(io_descs[i].size)),
+            static_cast<aon::IO_Type>(io_descs[i].type),
+            io_descs[i].num_dendrites_per_cell,
+            io_descs[i].up_radius,
+            io_descs[i].down_radius,
+            io_descs[i].value_size,
+            io_descs[i].value_num_dendrites_per_cell,
+            io_descs[i].history_capacity
+        );
+    }
+    
+    aon::Array<aon::Hierarchy::Layer_Desc> c_layer_descs(layer_descs.size());
+
+    for (int l = 0; l < layer_descs.size(); l++) {
+        layer_descs[l].check_in_range();
+
+        c_layer_descs[l] = aon::Hierarchy::Layer_Desc(
+            aon::Int3(std::get<0>(layer_descs[l].hidden_size), std::get<1>(layer_descs[l].hidden_size), std::get<2>(layer_descs[l].hidden_size)),
+            layer_descs[l].num_dendrites_per_cell,
+            layer_descs[l].up_radius,
+            layer_descs[l].recurrent_radius,
+            layer_descs[l].down_radius
+        );
+    }
+
+    // aon::Array is sized by int, so a first layer encoder visible layer (hidden cells x receptive area x input z weights)
+    // would silently overflow past 2^31 - 1 entries, spread the inputs over more IOs instead
+    if (!layer_descs.empty()) {
+        long long num_hidden_cells = static_cast<long long>(std::get<0>(layer_descs[0].hidden_size)) * std::get<1>(layer_descs[0].hidden_size) * std::get<2>(layer_descs[0].hidden_size);
+
+        for (int i = 0; i < io_descs.size(); i++) {
+            long long diam = io_descs[i].up_radius * 2 + 1;
+
+            long long num_weights = num_hidden_cells * diam * diam * std::get<2>(io_descs[i].size);
+
+            if (num_weights > std::numeric_limits<int>::max())
+                throw std::runtime_error("error: the encoder weights for IO " + std::to_string(i) + " would have " + std::to_string(num_weights) + " entries, more than a single array can hold (" + std::to_string(std::numeric_limits<int>::max()) + ") - reduce its up_radius or size, or split it into more IOs");
+        }
+    }
+
+    model().init_random(c_io_descs, c_layer_descs);
+}
+
+void Hierarchy::init_from_file(
+    const std::string &file_name
+) {
+    std::unique_ptr<Mapped_File> file(new Mapped_File(file_name, false));
+
+    if (is_container(file->get_data(), file->get_size())) {
+        // a bad index or meta section is rejected here, the model section is checked when it is read
+        std::vector<Container_Section> sections = read_container_index(file->get_data(), file->get_size());
+
+        const Container_Section &meta_section = find_section(sections, "meta");
+
+        verify_section(file->get_data(), meta_section);
+
+        Hierarchy_Meta meta = read_meta(file->get_data(), meta_section);
+
+        pending_meta = meta;
+        pending_sections = sections;
+        pending_file = std::move(file);
+
+        c_input_cis.resize(meta.io_sizes.size());
+
+        return;
+    }
+
+    file.reset();
+
+    read_file_maybe_compressed(file_name, [this](aon::Stream_Reader &reader) {
+        model().read(reader);
+    });
+}
+
+void Hierarchy::init_from_buffer(
+    const py::buffer &buffer
+) {
+    Buffer_Reader container_reader(buffer);
+
+    if (is_container(container_reader.data, container_reader.size)) {
+        std::vector<Container_Section> sections = read_container_index(container_reader.data, container_reader.size);
+
+        aon::Hierarchy &m = model();
+
+        py::gil_scoped_release release;
+
+        read_all_sections(m, container_reader.data, sections);
+
+        return;
+    }
+
+    read_maybe_compressed(buffer, [this](aon::Stream_Reader &reader) {
+        model().read(reader);
+    });
+}
+
+void Hierarchy::load_pending() {
+    Busy_Guard guard(this);
+
+    {
+        py::gil_scoped_release release;
+
+        read_all_sections(*h, pending_file->get_data(), pending_sections);
+    }
+
+    instance_params = h->params;
+
+    pending_file.reset();
+    pending_sections.clear();
+    pending_meta = Hierarchy_Meta();
+}
+
+void Hierarchy::load_sections_from_file(
+    const std::string &file_name,
+    const std::vector<std::string> &sections
+) {
+    bool has_weights = false;
+
+    for (int n = 0; n < sections.size(); n++) {
+        if (sections[n] != "state")
+            has_weights = true;
+    }
+
+    if (has_weights)
+        prepare_write();
+
+    Mapped_File file(file_name, false);
+
+    std::vector<Container_Section> index = read_container_index(file.get_data(), file.get_size());
+
+    root()->wait_idle();
+
+    aon::Hierarchy &m = model();
+
+    Busy_Guard guard(root());
+
+    py::gil_scoped_release release;
+
+    read_named_sections(m, file.get_data(), index, sections);
+}
+
+py::dict Hierarchy::read_file_info(
+    const std::string &file_name
+) {
+    Mapped_File file(file_name, false);
+
+    py::dict info;
+
+    info["size"] = file.get_size();
+
+    if (!is_container(file.get_data(), file.get_size())) {
+        info["indexed"] = false;
+        info["compressed"] = is_compressed(file.get_data(), file.get_size());
+
+        return info;
+    }
+
+    std::vector<Container_Section> sections = read_container_index(file.get_data(), file.get_size());
+
+    py::list section_list;
+
+    for (int s = 0; s < sections.size(); s++) {
+        py::dict section;
+
+        section["name"] = sections[s].name;
+        section["offset"] = sections[s].offset;
+        section["size"] = sections[s].size;
+
+        section_list.append(section);
+    }
+
+    const Container_Section &meta_section = find_section(sections, "meta");
+
+    verify_section(file.get_data(), meta_section);
+
+    Hierarchy_Meta meta = read_meta(file.get_data(), meta_section);
+
+    // older files hold the whole model in one section
+    bool has_state = false;
+
+    for (int s = 0; s < sections.size(); s++) {
+        if (sections[s].name == "state")
+            has_state = true;
+    }
+
+    const Container_Section &data_section = find_section(sections, (has_state ? "state" : "model"));
+
+    py::list io_sizes;
+    py::list io_types;
+    py::list hidden_sizes;
+
+    for (int i = 0; i < meta.io_sizes.size(); i++) {
+        io_sizes.append(py::make_tuple(meta.io_sizes[i].x, meta.io_sizes[i].y, meta.io_sizes[i].z));
+        io_types.append(py::cast(static_cast<IO_Type>(meta.io_types[i])));
+    }
+
+    for (int l = 0; l < meta.hidden_sizes.size(); l++)
+        hidden_sizes.append(py::make_tuple(meta.hidden_sizes[l].x, meta.hidden_sizes[l].y, meta.hidden_sizes[l].z));
+
+    info["indexed"] = true;
+    info["compressed"] = is_compressed(file.get_data() + data_section.offset, data_section.size);
+    info["sections"] = section_list;
+    info["io_sizes"] = io_sizes;
+    info["io_types"] = io_types;
+    info["hidden_sizes"] = hidden_sizes;
+
+    return info;
+}
+
+void Hierarchy::save_to_file(
+    const std::string &file_name,
+    bool compress,
+    bool indexed
+) {
+    if (indexed) {
+        // nothing may step while the sections are written, the GIL is held until they are copied out
+        root()->wait_idle();
+
+        aon::Hierarchy &m = model();
+
+        std::vector<Weights_Part> parts = get_weights_parts(m);
+
+        std::vector<std::string> names;
+        std::vector<std::vector<unsigned char>> buffers;
+
+        Struct_Writer structure;
+
+        Vector_Writer meta(0);
+
+        {
+            // this instance's params, swapped back before the GIL is released below
+            Params_Scope params_scope(this);
+
+            {
+                Recording_Writer writer(m.state_size());
+
+                m.write_state(writer);
+
+                structure.mask(writer);
+
+                names.push_back("state");
+                buffers.push_back(std::move(writer.buffer));
+            }
+
+            // offsets of the encoder visible layer weights within their sections, for reading receptive fields without loading the model
+            std::vector<std::vector<long long>> weights_offsets(m.get_num_layers());
+
+            for (int l = 0; l < m.get_num_layers(); l++)
+                weights_offsets[l].assign(m.get_encoder(l).get_num_visible_layers(), -1);
+
+            if (parts.empty()) {
+                Recording_Writer writer(m.weights_size());
+
+                m.write_weights(writer);
+
+                structure.mask(writer);
+
+                names.push_back("weights");
+                buffers.push_back(std::move(writer.buffer));
+            }
+            else {
+                for (int p = 0; p < parts.size(); p++) {
+                    Recording_Writer writer(get_part_weights_size(m, parts[p]));
+
+                    write_part_weights(m, parts[p], writer);
+
+                    structure.mask(writer);
+
+                    if (parts[p].type == part_encoder) {
+                        const aon::Encoder &enc = m.get_encoder(parts[p].l);
+
+                        for (int vli = 0; vli < enc.get_num_visible_layers(); vli++) {
+                            const void* weights = &enc.get_visible_layer(vli).weights[0];
+
+                            for (int w = 0; w < writer.writes.size(); w++) {
+                                if (writer.writes[w].data == weights && writer.writes[w].len == enc.get_visible_layer(vli).weights.size())
+                                    weights_offsets[parts[p].l][vli] = writer.writes[w].offset;
+                            }
+                        }
+                    }
+
+                    names.push_back(parts[p].name);
+                    buffers.push_back(std::move(writer.buffer));
+                }
+            }
+
+            // the live model is only read, the arrays written above come out as zero runs
+            m.write(structure);
+
+            write_meta(m, weights_offsets, meta);
+        }
+
+        py::gil_scoped_release release;
+
+        if (compress) {
+            for (int b = 0; b < buffers.size(); b++) {
+                std::vector<unsigned char> compressed;
+
+                compress_to(buffers[b].data(), buffers[b].size(), compressed);
+
+                buffers[b] = std::move(compressed);
+            }
+        }
+
+        std::vector<Section_Data> section_data;
+
+        section_data.push_back(Section_Data("meta", meta.buffer.data(), meta.buffer.size()));
+        section_data.push_back(Section_Data("struct", structure.buffer.data(), structure.buffer.size()));
+
+        for (int b = 0; b < buffers.size(); b++)
+            section_data.push_back(Section_Data(names[b], buffers[b].data(), buffers[b].size()));
+
+        save_container(file_name, section_data);
+
+        return;
+    }
+
+    root()->wait_idle();
+
+    aon::Hierarchy &m = model();
+
+    if (compress) {
+        Buffer_Writer writer(m.size() + sizeof(int));
+
+        {
+            // this instance's params, not those left in the shared model, swapped back before the GIL is released
+            Params_Scope params_scope(this);
+
+            m.write(writer);
+        }
+
+        save_compressed_to_file(file_name, writer.data, writer.start);
+
+        return;
+    }
+
+    // this instance's params, not those left in the shared model
+    Params_Scope params_scope(this);
+
+    File_Writer writer;
+    writer.outs.open(file_name, std::ios::binary);
+
+    m.write(writer);
+}
+
+Save_Handle Hierarchy::save_to_file_async(
+    const std::string &file_name,
+    bool compress
+) {
+    root()->wait_idle();
+
+    aon::Hierarchy &m = model();
+
+    Vector_Writer writer(m.size() + sizeof(int));
+
+    {
+        // this instance's params, not those left in the shared model
+        Params_Scope params_scope(this);
+
+        m.write(writer);
+    }
+
+    return Save_Handle(file_name, std::move(writer.buffer), compress);
+}
+
+void Hierarchy::set_state_from_buffer(
+    const py::buffer &buffer
+) {
+    read_maybe_compressed(buffer, [this](aon::Stream_Reader &reader) {
+        model().read_state(reader);
+    });
+}
+
+void Hierarchy::set_weights_from_buffer(
+    const py::buffer &buffer
+) {
+    prepare_write();
+
+    read_maybe_compressed(buffer, [this](aon::Stream_Reader &reader) {
+        model().read_weights(reader);
+    });
+}
+
+void Stage_Handle::wait() {
+    std::string error;
+
+    {
+        py::gil_scoped_release release;
+
+        std::unique_lock<std::mutex> lock(stage->mutex);
+
+        stage->cond.wait(lock, [this]() { return stage->finished; });
+
+        error = stage->error;
+    }
+
+    if (!error.empty())
+        throw std::runtime_error(error);
+}
+
+Stage_Handle Hierarchy::stage_weights_from_buffer(
+    const py::buffer &buffer
+) {
+    Hierarchy* owner = root();
+
+    // one stage at a time, a previous one is replaced once its thread is done with it
+    if (owner->weights_stage != nullptr) {
+        std::shared_ptr<Weights_Stage> previous = owner->weights_stage;
+
+        py::gil_scoped_release release;
+
+        std::unique_lock<std::mutex> lock(previous->mutex);
+
+        previous->cond.wait(lock, [&previous]() { return previous->finished; });
+    }
+
+    owner->weights_stage.reset();
+
+    // copied while the GIL is held, so the caller may reuse its buffer right away
+    Buffer_Reader reader(buffer);
+
+    std::vector<unsigned char> data(reader.data, reader.data + reader.size);
+
+    // the structure of the model without its weights and state arrays (see Struct_Writer), which the background
+    // thread reads into the standby model, addresses only, so this costs about the size of the non-array parts
+    owner->wait_idle();
+
+    aon::Hierarchy &m = model();
+
+    Struct_Writer skeleton;
+
+    {
+        Address_Writer state;
+
+        m.write_state(state);
+
+        skeleton.mask(state);
+
+        Address_Writer weights;
+
+        m.write_weights(weights);
+
+        skeleton.mask(weights);
+    }
+
+    m.write(skeleton);
+
+    long long expected_size = m.weights_size();
+
+    std::shared_ptr<Weights_Stage> stage = std::make_shared<Weights_Stage>();
+
+    // counted before the thread starts, so interpreter exit waits for it
+    std::shared_ptr<Background_Task> task = std::make_shared<Background_Task>();
+
+    // touches only the stage and its own copies, never the model, so it may outlive the hierarchy
+    std::thread thread([stage, task, data = std::move(data), structure = std::move(skeleton.buffer), expected_size]() mutable {
+        std::string error;
+
+        std::unique_ptr<aon::Hierarchy> standby;
+
+        try {
+            if (is_compressed(data.data(), data.size())) {
+                std::vector<unsigned char> raw(get_decompressed_size(data.data(), data.size()));
+
+                decompress_to(data.data(), data.size(), raw.data());
+
+                data = std::move(raw);
+            }
+
+            // checked here, so a mismatch never reaches the live model
+            if (static_cast<long long>(data.size()) != expected_size)
+                throw std::runtime_error("error: staged weights do not match the structure of this hierarchy (" + std::to_string(data.size()) + " bytes, expected " + std::to_string(expected_size) + ")!");
+
+            standby.reset(new aon::Hierarchy());
+
+            Struct_Reader structure_reader(structure.data(), structure.size());
+
+            standby->read(structure_reader);
+
+            std::vector<unsigned char>().swap(structure);
+
+            Vector_Reader weights_reader(data);
+
+            standby->read_weights(weights_reader);
+        }
+        catch (const std::exception &e) {
+            error = e.what();
+
+            standby.reset();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(stage->mutex);
+
+            stage->error = error;
+            stage->standby = std::move(standby);
+            stage->finished = true;
+        }
+
+        stage->cond.notify_all();
+
+        task.reset();
+    });
+
+    thread.detach();
+
+    owner->weights_stage = stage;
+
+    return Stage_Handle(stage);
+}
+
+bool Hierarchy::swap_staged_weights(
+    bool wait
+) {
+    Hierarchy* owner = root();
+
+    std::shared_ptr<Weights_Stage> stage = owner->weights_stage;
+
+    if (stage == nullptr)
+        return false;
+
+    if (!wait) {
+        std::lock_guard<std::mutex> lock(stage->mutex);
+
+        if (!stage->finished)
+            return false;
+    }
+    else {
+        py::gil_scoped_release release;
+
+        std::unique_lock<std::mutex> lock(stage->mutex);
+
+        stage->cond.wait(lock, [&stage]() { return stage->finished; });
+    }
+
+    // a step of another instance sharing this model is running, so it is deferred to the next step
+    if (owner->busy) {
+        if (!wait)
+            return false;
+
+        owner->wait_idle();
+    }
+
+    owner->weights_stage.reset();
+
+    // reported through the stage handle, serving carries on with the live weights
+    if (!stage->error.empty())
+        return false;
+
+    std::unique_ptr<aon::Hierarchy> standby;
+
+    {
+        std::lock_guard<std::mutex> lock(stage->mutex);
+
+        standby = std::move(stage->standby);
+    }
+
+    // runs with the GIL held and nothing busy, so no step can start midway
+    if (owner->get_num_model_views() > 0) {
+        // copy = false views point into the live buffers, so they are kept by copying the weights in place instead
+        Vector_Writer writer(standby->weights_size());
+
+        standby->write_weights(writer);
+
+        Vector_Reader reader(writer.buffer);
+
+        owner->h->read_weights(reader);
+    }
+    else {
+        // the active state moves over, parked states and params live outside the model
+        Vector_Writer writer(owner->h->state_size());
+
+        owner->h->write_state(writer);
+
+        Vector_Reader reader(writer.buffer);
+
+        standby->read_state(reader);
+
+        owner->h.swap(standby);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stage->mutex);
+
+        stage->applied = true;
+    }
+
+    // standby now holds the previous model, freed on return
+    return true;
+}
+
+py::array_t<unsigned char> Hierarchy::serialize_to_buffer(
+    bool compress
+) {
+    root()->wait_idle();
+
+    aon::Hierarchy &m = model();
+
+    Buffer_Writer writer(m.size() + sizeof(int));
+
+    {
+        // this instance's params, not those left in the shared model
+        Params_Scope params_scope(this);
+
+        m.write(writer);
+    }
+
+    if (compress)
+        return compress_buffer(writer.data, writer.start);
+
+    return writer.buffer;
+}
+
+py::array_t<unsigned char> Hierarchy::serialize_state_to_buffer() {
+    Buffer_Writer writer(model().state_size());
+
+    model().write_state(writer);
+
+    return writer.buffer;
+}
+
+py::array_t<unsigned char> Hierarchy::serialize_weights_to_buffer(
+    bool compress
+) {
+    Buffer_Writer writer(model().weights_size());
+
+    model().write_weights(writer);
+
+    if (compress)
+        return compress_buffer(writer.data, writer.start);
+
+    return writer.buffer;
+}
+
+py::array_t<unsigned char> Hierarchy::serialize_state_delta(
+    const py::buffer &base
+) {
+    Delta_Writer writer(base);
+
+    model().write_state(writer);
+
+    return writer.finish();
+}
+
+void Hierarchy::apply_state_delta(
+    const py::buffer &base,
+    const py::buffer &delta
+) {
+    py::array_t<unsigned char> state = apply_delta(base, delta);
+
+    Buffer_Reader reader(state);
+
+    model().read_state(reader);
+}
+
+void Hierarchy::step(
+    const std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> &input_cis,
+    bool learn_enabled,
+    float reward,
+    float mimic,
+    bool validate
+) {
+    bool profiling = profiler.is_enabled();
+
+    double start_time = (profiling ? Step_Profiler::now() : 0.0);
+
+    // staged weights are swapped in between steps, once they have been read
+    if (root()->weights_stage != nullptr)
+        swap_staged_weights(false);
+
+    if (learn_enabled)
+        prepare_write();
+
+    if (input_cis.size() != model().get_num_io())
+        throw std::runtime_error("incorrect number of input_cis passed to step! received " + std::to_string(input_cis.size()) + ", need " + std::to_string(model().get_num_io()));
+
+    for (int i = 0; i < input_cis.size(); i++) {
+        aon::Int3 io_size = model().get_io_size(i);
+
+        int num_columns = io_size.x * io_size.y;
+
+        if (input_cis[i].size() != num_columns)
+            throw std::runtime_error("incorrect csdr size at index " + std::to_string(i) + " - expected " + std::to_string(num_columns) + " columns, got " + std::to_string(input_cis[i].size()));
+
+        const int* data = input_cis[i].data();
+
+        if (validate && !cis_in_range(data, num_columns, io_size.z)) {
+            // slow path, only to report the offending column
+            for (int j = 0; j < num_columns; j++) {
+                if (data[j] < 0 || data[j] >= io_size.z)
+                    throw std::runtime_error("input csdr at input index " + std::to_string(i) + " has an out-of-bounds column index (" + std::to_string(data[j]) + ") at column index " + std::to_string(j) + ". it must be in the range [0, " + std::to_string(io_size.z - 1) + "]");
+            }
+        }
+
+        // forcecast already produced C-contiguous int32 data (without copying if it already was), view it directly since it outlives the step
+        c_input_cis[i] = aon::Int_Buffer_View(const_cast<int*>(data), num_columns);
+    }
+
+    // taken last while the GIL is held, so the state loaded is this instance's until the guard is released
+    aon::Hierarchy &m = model();
+
+    Params_Scope params_scope(this);
+
+    if (!profiling) {
+        Busy_Guard guard(root());
+
+        // no Python objects are touched past this point
+        py::gil_scoped_release release;
+
+        Execution_Scope scope(execution, learn_enabled);
+
+        m.step(c_input_cis, learn_enabled, reward, mimic);
+
+        return;
     }
 
-    // copy params
-    params.ios.resize(h.get_num_io());
+    double inputs_end_time = Step_Profiler::now();
 
-    for (int i = 0; i < h.get_num_io(); i++)
-        params.ios[i] = h.params.ios[i];
+    {
+        Busy_Guard guard(root());
 
-    // copy params
-    params.layers.resize(h.get_num_layers());
+        py::gil_scoped_release release;
 
-    for (int l = 0; l < h.get_num_layers(); l++)
-        params.layers[l] = h.params.layers[l];
+        Execution_Scope scope(execution, learn_enabled);
 
-    params.anticipation = h.params.anticipation;
+        m.step(c_input_cis, learn_enabled, reward, mimic);
+    }
 
-    c_input_cis_backing.resize(h.get_num_io());
-    c_input_cis.resize(h.get_num_io());
+    double end_time = Step_Profiler::now();
 
-    for (int i = 0; i < c_input_cis_backing.size(); i++)
-        c_input_cis_backing[i].resize(h.get_io_size(i).x * h.get_io_size(i).y);
+    profiler.add(profile_inputs, inputs_end_time - start_time);
+    profiler.add(profile_core_step, end_time - inputs_end_time);
+    profiler.add(profile_total, end_time - start_time);
 }
 
-void Hierarchy::init_random(
-    const std::vector<IO_Desc> &io_descs,
-    const std::vector<Layer_Desc> &layer_descs
+py::object Hierarchy::step_sequence(
+    const std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> &input_cis,
+    bool learn_enabled,
+    const py::array_t<float, py::array::c_style | py::array::forcecast> &rewards,
+    const py::array_t<float, py::array::c_style | py::array::forcecast> &mimics,
+    bool capture_hidden,
+    bool validate
 ) {
-    aon::Array<aon::Hierarchy::IO_Desc> c_io_descs(io_descs.size());
+    if (root()->weights_stage != nullptr)
+        swap_staged_weights(false);
 
-    for (int i = 0; i < io_descs.size(); i++) {
-        io_descs[i].check_in_range();
+    if (learn_enabled)
+        prepare_write();
 
-        c_io_descs[i] = aon::Hierarchy::IO_Desc(
-            aon::Int3(std::get<0>(io_descs[i].size), std::get<1>(io_descs[i].size), std::get<2>(io_descs[i].size)),
-            static_cast<aon::IO_Type>(io_descs[i].type),
-            io_descs[i].num_dendrites_per_cell,
-            io_descs[i].up_radius,
-            io_descs[i].down_radius,
-            io_descs[i].value_size,
-            io_descs[i].value_num_dendrites_per_cell,
-            io_descs[i].history_capacity
-        );
-    }
-    
-    aon::Array<aon::Hierarchy::Layer_Desc> c_layer_descs(layer_descs.size());
+    if (input_cis.size() != model().get_num_io())
+        throw std::runtime_error("incorrect number of input_cis passed to step_sequence! received " + std::to_string(input_cis.size()) + ", need " + std::to_string(model().get_num_io()));
 
-    for (int l = 0; l < layer_descs.size(); l++) {
-        layer_descs[l].check_in_range();
+    if (input_cis[0].ndim() != 2)
+        throw std::runtime_error("input_cis passed to step_sequence must be 2D (T, num_columns)!");
 
-        c_layer_descs[l] = aon::Hierarchy::Layer_Desc(
-            aon::Int3(std::get<0>(layer_descs[l].hidden_size), std::get<1>(layer_descs[l].hidden_size), std::get<2>(layer_descs[l].hidden_size)),
-            layer_descs[l].num_dendrites_per_cell,
-            layer_descs[l].up_radius,
-            layer_descs[l].recurrent_radius,
-            layer_descs[l].down_radius
-        );
+    int num_steps = input_cis[0].shape(0);
+
+    if (rewards.size() != 1 && rewards.size() != num_steps)
+        throw std::runtime_error("incorrect number of rewards passed to step_sequence! received " + std::to_string(rewards.size()) + ", need 1 or " + std::to_string(num_steps));
+
+    if (mimics.size() != 1 && mimics.size() != num_steps)
+        throw std::runtime_error("incorrect number of mimics passed to step_sequence! received " + std::to_string(mimics.size()) + ", need 1 or " + std::to_string(num_steps));
+
+    std::vector<const int*> inputs_data(model().get_num_io());
+
+    for (int i = 0; i < input_cis.size(); i++) {
+        aon::Int3 io_size = model().get_io_size(i);
+
+        int num_columns = io_size.x * io_size.y;
+
+        if (input_cis[i].ndim() != 2 || input_cis[i].shape(0) != num_steps || input_cis[i].shape(1) != num_columns)
+            throw std::runtime_error("incorrect csdr shape at index " + std::to_string(i) + " - expected (" + std::to_string(num_steps) + ", " + std::to_string(num_columns) + ")");
+
+        inputs_data[i] = input_cis[i].data();
+
+        if (validate && !cis_in_range(inputs_data[i], input_cis[i].size(), io_size.z)) {
+            // slow path, only to report the offending column
+            for (long long j = 0; j < input_cis[i].size(); j++) {
+                if (inputs_data[i][j] < 0 || inputs_data[i][j] >= io_size.z)
+                    throw std::runtime_error("input csdr at input index " + std::to_string(i) + " has an out-of-bounds column index (" + std::to_string(inputs_data[i][j]) + ") at step " + std::to_string(j / num_columns) + ", column index " + std::to_string(j % num_columns) + ". it must be in the range [0, " + std::to_string(io_size.z - 1) + "]");
+            }
+        }
     }
 
-    h.init_random(c_io_descs, c_layer_descs);
-}
+    // allocate all outputs while holding the GIL
+    py::list predictions;
+    std::vector<int*> predictions_data(model().get_num_io(), nullptr);
 
-void Hierarchy::init_from_file(
-    const std::string &file_name
-) {
-    File_Reader reader;
-    reader.ins.open(file_name, std::ios::binary);
+    for (int i = 0; i < model().get_num_io(); i++) {
+        if (!model().io_layer_exists(i) || model().get_io_type(i) == aon::none) {
+            predictions.append(py::none());
 
-    h.read(reader);
-}
+            continue;
+        }
 
-void Hierarchy::init_from_buffer(
-    const py::array_t<unsigned char> &buffer
-) {
-    Buffer_Reader reader;
-    reader.buffer = &buffer;
+        py::array_t<int> prediction({ num_steps, model().get_prediction_cis(i).size() });
 
-    h.read(reader);
-}
+        predictions_data[i] = prediction.mutable_data();
+        predictions.append(prediction);
+    }
 
-void Hierarchy::save_to_file(
-    const std::string &file_name
-) {
-    File_Writer writer;
-    writer.outs.open(file_name, std::ios::binary);
+    py::list hidden_cis;
+    std::vector<int*> hidden_cis_data;
 
-    h.write(writer);
-}
+    if (capture_hidden) {
+        hidden_cis_data.resize(model().get_num_layers());
 
-void Hierarchy::set_state_from_buffer(
-    const py::array_t<unsigned char> &buffer
-) {
-    Buffer_Reader reader;
-    reader.buffer = &buffer;
+        for (int l = 0; l < model().get_num_layers(); l++) {
+            py::array_t<int> layer_hidden_cis({ num_steps, model().get_encoder(l).get_hidden_cis().size() });
 
-    h.read_state(reader);
-}
+            hidden_cis_data[l] = layer_hidden_cis.mutable_data();
+            hidden_cis.append(layer_hidden_cis);
+        }
+    }
 
-void Hierarchy::set_weights_from_buffer(
-    const py::array_t<unsigned char> &buffer
-) {
-    Buffer_Reader reader;
-    reader.buffer = &buffer;
+    const float* rewards_data = rewards.data();
+    const float* mimics_data = mimics.data();
 
-    h.read_weights(reader);
-}
+    int reward_stride = (rewards.size() == 1 ? 0 : 1);
+    int mimic_stride = (mimics.size() == 1 ? 0 : 1);
 
-py::array_t<unsigned char> Hierarchy::serialize_to_buffer() {
-    Buffer_Writer writer(h.size() + sizeof(int));
+    bool profiling = profiler.is_enabled();
 
-    h.write(writer);
+    aon::Hierarchy &m = model();
 
-    return writer.buffer;
-}
+    Params_Scope params_scope(this);
 
-py::array_t<unsigned char> Hierarchy::serialize_state_to_buffer() {
-    Buffer_Writer writer(h.state_size());
+    {
+        Busy_Guard guard(root());
 
-    h.write_state(writer);
+        py::gil_scoped_release release;
 
-    return writer.buffer;
-}
+        Execution_Scope scope(execution, learn_enabled);
 
-py::array_t<unsigned char> Hierarchy::serialize_weights_to_buffer() {
-    Buffer_Writer writer(h.weights_size());
+        for (int t = 0; t < num_steps; t++) {
+            double start_time = (profiling ? Step_Profiler::now() : 0.0);
 
-    h.write_weights(writer);
+            for (int i = 0; i < m.get_num_io(); i++) {
+                int num_columns = m.get_io_size(i).x * m.get_io_size(i).y;
 
-    return writer.buffer;
-}
+                c_input_cis[i] = aon::Int_Buffer_View(const_cast<int*>(inputs_data[i] + static_cast<long long>(t) * num_columns), num_columns);
+            }
 
-void Hierarchy::step(
-    const std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> &input_cis,
-    bool learn_enabled,
-    float reward,
-    float mimic
-) {
-    if (input_cis.size() != h.get_num_io())
-        throw std::runtime_error("incorrect number of input_cis passed to step! received " + std::to_string(input_cis.size()) + ", need " + std::to_string(h.get_num_io()));
+            double step_start_time = (profiling ? Step_Profiler::now() : 0.0);
 
-    copy_params_to_h();
+            m.step(c_input_cis, learn_enabled, rewards_data[t * reward_stride], mimics_data[t * mimic_stride]);
 
-    for (int i = 0; i < input_cis.size(); i++) {
-        auto view = input_cis[i].unchecked();
+            double step_end_time = (profiling ? Step_Profiler::now() : 0.0);
 
-        int num_columns = h.get_io_size(i).x * h.get_io_size(i).y;
+            for (int i = 0; i < m.get_num_io(); i++) {
+                if (predictions_data[i] == nullptr)
+                    continue;
 
-        if (view.size() != num_columns)
-            throw std::runtime_error("incorrect csdr size at index " + std::to_string(i) + " - expected " + std::to_string(num_columns) + " columns, got " + std::to_string(view.size()));
+                const aon::Int_Buffer &cis = m.get_prediction_cis(i);
 
-        for (int j = 0; j < view.size(); j++) {
-            if (view(j) < 0 || view(j) >= h.get_io_size(i).z)
-                throw std::runtime_error("input csdr at input index " + std::to_string(i) + " has an out-of-bounds column index (" + std::to_string(view(j)) + ") at column index " + std::to_string(j) + ". it must be in the range [0, " + std::to_string(h.get_io_size(i).z - 1) + "]");
+                std::memcpy(predictions_data[i] + static_cast<long long>(t) * cis.size(), &cis[0], cis.size() * sizeof(int));
+            }
 
-            c_input_cis_backing[i][j] = view(j);
-        }
+            for (int l = 0; l < hidden_cis_data.size(); l++) {
+                const aon::Int_Buffer &cis = m.get_encoder(l).get_hidden_cis();
+
+                std::memcpy(hidden_cis_data[l] + static_cast<long long>(t) * cis.size(), &cis[0], cis.size() * sizeof(int));
+            }
 
-        c_input_cis[i] = c_input_cis_backing[i];
+            if (profiling) {
+                double end_time = Step_Profiler::now();
+
+                profiler.add(profile_inputs, step_start_time - start_time);
+                profiler.add(profile_core_step, step_end_time - step_start_time);
+                profiler.add(profile_outputs, end_time - step_end_time);
+                profiler.add(profile_total, end_time - start_time);
+            }
+        }
     }
-    
-    h.step(c_input_cis, learn_enabled, reward, mimic);
+
+    if (capture_hidden)
+        return py::make_tuple(predictions, hidden_cis);
+
+    return predictions;
 }
 
 py::array_t<int> Hierarchy::get_prediction_cis(
-    int i
+    int i,
+    bool copy,
+    const py::object &out
 ) const {
-    if (i < 0 || i >= h.get_num_io())
-        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(h.get_num_io() - 1) + "]!");
+    if (i < 0 || i >= model().get_num_io())
+        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(model().get_num_io() - 1) + "]!");
 
-    if (!h.io_layer_exists(i) || h.get_io_type(i) == aon::none)
+    if (!model().io_layer_exists(i) || model().get_io_type(i) == aon::none)
         throw std::runtime_error("no decoder exists at index " + std::to_string(i) + " - did you set it to the correct type?");
 
-    py::array_t<int> predictions(h.get_prediction_cis(i).size());
+    check_view_allowed(copy, out);
 
-    auto view = predictions.mutable_unchecked();
-
-    for (int j = 0; j < view.size(); j++)
-        view(j) = h.get_prediction_cis(i)[j];
-
-    return predictions;
+    return buffer_to_numpy(model().get_prediction_cis(i), copy, out, this);
 }
 
 py::array_t<int> Hierarchy::get_layer_prediction_cis(
-    int l
+    int l,
+    bool copy,
+    const py::object &out
 ) const {
-    if (l < 1 || l >= h.get_num_layers())
-        throw std::runtime_error("layer index " + std::to_string(l) + " out of range [1, " + std::to_string(h.get_num_layers() - 1) + "]!");
+    if (l < 1 || l >= model().get_num_layers())
+        throw std::runtime_error("layer index " + std::to_string(l) + " out of range [1, " + std::to_string(model().get_num_layers() - 1) + "]!");
 
-    const aon::Int_Buffer &cis = h.get_decoder(l, 0).get_hidden_cis();
+    check_view_allowed(copy, out);
 
-    py::array_t<int> predictions(cis.size());
+    return buffer_to_numpy(model().get_decoder(l, 0).get_hidden_cis(), copy, out, this);
+}
+
+py::array_t<float> Hierarchy::get_prediction_acts(
+    int i,
+    bool copy,
+    const py::object &out
+) const {
+    if (i < 0 || i >= model().get_num_io())
+        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(model().get_num_io() - 1) + "]!");
 
-    auto view = predictions.mutable_unchecked();
+    if (!model().io_layer_exists(i) || model().get_io_type(i) == aon::none)
+        throw std::runtime_error("no decoder or actor exists at index " + std::to_string(i) + " - did you set it to the correct type?");
 
-    for (int j = 0; j < view.size(); j++)
-        view(j) = cis[j];
+    check_view_allowed(copy, out);
 
-    return predictions;
+    return buffer_to_numpy(model().get_prediction_acts(i), copy, out, this);
 }
 
-py::array_t<float> Hierarchy::get_prediction_acts(
-    int i
+void Hierarchy::sample_prediction_into(
+    int i,
+    float temperature,
+    std::uint64_t base_state,
+    int* sample
 ) const {
-    if (i < 0 || i >= h.get_num_io())
-        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(h.get_num_io() - 1) + "]!");
+    const aon::Float_Buffer &acts = model().get_prediction_acts(i);
 
-    if (!h.io_layer_exists(i) || h.get_io_type(i) == aon::none)
-        throw std::runtime_error("no decoder or actor exists at index " + std::to_string(i) + " - did you set it to the correct type?");
+    int num_columns = model().get_prediction_cis(i).size();
+    int size_z = model().get_io_size(i).z;
 
-    py::array_t<float> predictions(h.get_prediction_acts(i).size());
+    if (sample_scratch.size() < acts.size())
+        sample_scratch.resize(acts.size());
 
-    auto view = predictions.mutable_unchecked();
+    float temperature_inv = 1.0f / temperature;
 
-    for (int j = 0; j < view.size(); j++)
-        view(j) = h.get_prediction_acts(i)[j];
+    #pragma omp parallel for
+    for (int j = 0; j < num_columns; j++) {
+        int cells_start = j * size_z;
 
-    return predictions;
+        // power once into scratch, then scan the scratch
+        float total = 0.0f;
+
+        for (int k = 0; k < size_z; k++) {
+            float p = aon::powf(acts[k + cells_start], temperature_inv);
+
+            sample_scratch[k + cells_start] = p;
+
+            total += p;
+        }
+
+        // per column position in the stream, so results do not depend on the thread count
+        std::uint64_t state = base_state + j * 0x9e3779b97f4a7c15ull;
+
+        float cusp = stream_randf(state) * total;
+
+        float sum_so_far = 0.0f;
+
+        int selected_index = size_z - 1;
+
+        for (int k = 0; k < size_z; k++) {
+            sum_so_far += sample_scratch[k + cells_start];
+
+            if (sum_so_far >= cusp) {
+                selected_index = k;
+
+                break;
+            }
+        }
+
+        sample[j] = selected_index;
+    }
 }
 
 py::array_t<int> Hierarchy::sample_prediction(
@@ -300,152 +2029,313 @@ py::array_t<int> Hierarchy::sample_prediction(
     float temperature
 ) const {
     if (temperature == 0.0f)
-        return get_prediction_cis(i);
+        return get_prediction_cis(i, true, py::none());
 
-    if (i < 0 || i >= h.get_num_io())
-        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(h.get_num_io() - 1) + "]!");
+    if (i < 0 || i >= model().get_num_io())
+        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(model().get_num_io() - 1) + "]!");
 
-    if (!h.io_layer_exists(i) || h.get_io_type(i) == aon::none)
+    if (!model().io_layer_exists(i) || model().get_io_type(i) == aon::none)
         throw std::runtime_error("no decoder or actor exists at index " + std::to_string(i) + " - did you set it to the correct type?");
 
-    py::array_t<int> sample(h.get_prediction_cis(i).size());
+    py::array_t<int> sample(model().get_prediction_cis(i).size());
 
-    auto view = sample.mutable_unchecked();
+    sample_prediction_into(i, temperature, stream_rand(sample_state), sample.mutable_data());
 
-    int size_z = h.get_io_size(i).z;
+    return sample;
+}
 
-    float temperature_inv = 1.0f / temperature;
+std::vector<py::object> Hierarchy::sample_predictions(
+    const std::vector<float> &temperatures
+) const {
+    if (temperatures.size() != model().get_num_io())
+        throw std::runtime_error("incorrect number of temperatures passed to sample_predictions! received " + std::to_string(temperatures.size()) + ", need " + std::to_string(model().get_num_io()));
 
-    for (int j = 0; j < view.size(); j++) {
-        float total = 0.0f;
+    std::vector<py::object> samples(model().get_num_io(), py::none());
 
-        for (int k = 0; k < size_z; k++)
-            total += aon::powf(h.get_prediction_acts(i)[k + j * size_z], temperature_inv);
+    // allocate all outputs while holding the GIL
+    std::vector<int*> samples_data(model().get_num_io(), nullptr);
 
-        float cusp = aon::randf() * total;
+    for (int i = 0; i < model().get_num_io(); i++) {
+        if (!model().io_layer_exists(i) || model().get_io_type(i) == aon::none)
+            continue;
 
-        float sum_so_far = 0.0f;
+        py::array_t<int> sample(model().get_prediction_cis(i).size());
 
-        for (int k = 0; k < size_z; k++) {
-            sum_so_far += aon::powf(h.get_prediction_acts(i)[k + j * size_z], temperature_inv);
+        samples_data[i] = sample.mutable_data();
+        samples[i] = sample;
+    }
 
-            if (sum_so_far >= cusp) {
-                view(j) = k;
+    // this instance's state must be the loaded one before the GIL is released
+    model();
 
-                break;
+    {
+        Busy_Guard guard(root());
+
+        py::gil_scoped_release release;
+
+        for (int i = 0; i < model().get_num_io(); i++) {
+            if (samples_data[i] == nullptr)
+                continue;
+
+            if (temperatures[i] == 0.0f) {
+                const aon::Int_Buffer &cis = model().get_prediction_cis(i);
+
+                std::memcpy(samples_data[i], &cis[0], cis.size() * sizeof(int));
             }
+            else
+                sample_prediction_into(i, temperatures[i], stream_rand(sample_state), samples_data[i]);
         }
     }
 
-    return sample;
+    return samples;
 }
 
 py::array_t<int> Hierarchy::get_hidden_cis(
-    int l
-) {
-    if (l < 0 || l >= h.get_num_layers())
+    int l,
+    bool copy,
+    const py::object &out
+) const {
+    if (l < 0 || l >= model().get_num_layers())
         throw std::runtime_error("error: " + std::to_string(l) + " is not a valid layer index!");
 
-    py::array_t<int> hidden_cis(h.get_encoder(l).get_hidden_cis().size());
+    check_view_allowed(copy, out);
+
+    return buffer_to_numpy(model().get_encoder(l).get_hidden_cis(), copy, out, this);
+}
 
-    auto view = hidden_cis.mutable_unchecked();
+void Hierarchy::set_execution(
+    int num_threads,
+    const std::vector<int> &cpus,
+    bool first_touch
+) {
+    execution.set(num_threads, cpus);
 
-    for (int j = 0; j < view.size(); j++)
-        view(j) = h.get_encoder(l).get_hidden_cis()[j];
+    if (!first_touch || cpus.empty())
+        return;
 
-    return hidden_cis;
-}
+    check_no_model_views("set_execution(first_touch=True)");
 
-void Hierarchy::copy_params_to_h() {
-    if (params.ios.size() != h.params.ios.size())
-        throw std::runtime_error("ios parameter size mismatch - did you modify the length of params.ios?");
+    Hierarchy* owner = root();
 
-    if (params.layers.size() != h.params.layers.size())
-        throw std::runtime_error("layers parameter size mismatch - did you modify the length of params.layers?");
-    
-    // copy params
-    for (int i = 0; i < params.ios.size(); i++)
-        h.params.ios[i] = params.ios[i];
+    // loads a pending indexed file first, so it is part of the round trip
+    model();
+
+    owner->wait_idle();
+
+    {
+        Busy_Guard guard(owner);
 
-    // copy params
-    for (int l = 0; l < params.layers.size(); l++)
-        h.params.layers[l] = params.layers[l];
+        py::gil_scoped_release release;
 
-    h.params.anticipation = params.anticipation;
+        // a full round trip keeps every state parked or loaded as it was
+        // the read reallocates every buffer of the model (first touched on the pinned thread), so pointers into the old ones
+        // dangle afterwards: copy = false views were refused above, and nothing else holds such pointers across calls
+        execution.run_pinned([owner]() {
+            Vector_Writer writer(owner->h->size() + sizeof(int));
+
+            owner->h->write(writer);
+
+            Vector_Reader reader(writer.buffer);
+
+            owner->h->read(reader);
+        });
+    }
 }
 
-std::tuple<py::array_t<unsigned char>, std::tuple<int, int, int>> Hierarchy::get_encoder_receptive_field(
-    int l,
-    int vli,
-    const std::tuple<int, int, int> &pos
+py::dict Hierarchy::autotune(
+    int num_steps,
+    int max_threads,
+    bool learn
 ) {
-    if (l < 0 || l >= h.get_num_layers())
-        throw std::runtime_error("layer index " + std::to_string(l) + " out of range [0, " + std::to_string(h.get_num_layers() - 1) + "]!");
+    if (num_steps < 1)
+        throw std::runtime_error("error: num_steps must be >= 1!");
 
-    const aon::Encoder &enc = h.get_encoder(l);
+    if (max_threads < 0)
+        throw std::runtime_error("error: max_threads must be >= 0 (0 uses the number of hardware threads)!");
 
-    int num_visible_layers = enc.get_num_visible_layers();
+    if (max_threads == 0)
+        max_threads = aon::max(1, static_cast<int>(std::thread::hardware_concurrency()));
 
-    if (vli < 0 || vli >= num_visible_layers)
-        throw std::runtime_error("visible layer index " + std::to_string(vli) + " out of range [0, " + std::to_string(num_visible_layers - 1) + "]!");
+    std::vector<int> candidates;
 
-    const aon::Int3 &hidden_size = enc.get_hidden_size();
+    for (int n = 1; n < max_threads; n *= 2)
+        candidates.push_back(n);
 
-    if (std::get<0>(pos) < 0 || std::get<0>(pos) >= hidden_size.x ||
-        std::get<1>(pos) < 0 || std::get<1>(pos) >= hidden_size.y ||
-        std::get<2>(pos) < 0 || std::get<2>(pos) >= hidden_size.z) {
-        throw std::runtime_error("position (" + std::to_string(std::get<0>(pos)) + ", " + std::to_string(std::get<1>(pos)) + ", " + std::to_string(std::get<2>(pos)) + ") " +
-                + " not in size (" + std::to_string(hidden_size.x) + ", " + std::to_string(hidden_size.y) + ", " + std::to_string(hidden_size.z) + ")!");
-    }
+    candidates.push_back(max_threads);
 
-    const aon::Encoder::Visible_Layer &vl = enc.get_visible_layer(vli);
-    const aon::Encoder::Visible_Layer_Desc &vld = enc.get_visible_layer_desc(vli);
+    Hierarchy* owner = root();
 
-    int diam = vld.radius * 2 + 1;
-    int area = diam * diam;
+    owner->wait_idle();
 
-    aon::Int2 column_pos(std::get<0>(pos), std::get<1>(pos));
+    aon::Hierarchy &m = model();
 
-    int hidden_column_index = aon::address2(column_pos, aon::Int2(hidden_size.x, hidden_size.y));
-    int hidden_cells_start = hidden_size.z * hidden_column_index;
+    int num_io = m.get_num_io();
 
-    // projection
-    aon::Float2 h_to_v = aon::Float2(static_cast<float>(vld.size.x) / static_cast<float>(hidden_size.x),
-            static_cast<float>(vld.size.y) / static_cast<float>(hidden_size.y));
+    // random inputs from a private stream (a copy of the sampling stream, which is left as it was)
+    std::uint64_t input_state = sample_state;
 
-    aon::Int2 visible_center = project(column_pos, h_to_v);
+    std::vector<std::vector<int>> inputs(num_io);
 
-        // lower corner
-    aon::Int2 field_lower_bound(visible_center.x - vld.radius, visible_center.y - vld.radius);
+    for (int i = 0; i < num_io; i++) {
+        aon::Int3 io_size = m.get_io_size(i);
 
-        // bounds of receptive field, clamped to input size
-    aon::Int2 iter_lower_bound(aon::max(0, field_lower_bound.x), aon::max(0, field_lower_bound.y));
-    aon::Int2 iter_upper_bound(aon::min(vld.size.x - 1, visible_center.x + vld.radius), aon::min(vld.size.y - 1, visible_center.y + vld.radius));
+        inputs[i].resize(static_cast<long long>(num_steps) * io_size.x * io_size.y);
 
-    int field_count = area * vld.size.z;
+        for (int j = 0; j < inputs[i].size(); j++)
+            inputs[i][j] = stream_rand(input_state) % io_size.z;
+    }
 
-    py::array_t<unsigned char> field(field_count);
+    aon::Array<aon::Int_Buffer_View> c_inputs(num_io);
 
-    auto view = field.mutable_unchecked();
+    // median step time per candidate, does not touch Python objects
+    auto time_candidates = [&](aon::Hierarchy &target, bool learn_enabled, std::vector<double> &times) {
+        times.resize(candidates.size());
 
-    // first clear
-    for (int i = 0; i < field_count; i++)
-        view(i) = 0;
+        for (int c = 0; c < candidates.size(); c++) {
+            Execution_Settings settings = execution;
 
-    for (int ix = iter_lower_bound.x; ix <= iter_upper_bound.x; ix++)
-        for (int iy = iter_lower_bound.y; iy <= iter_upper_bound.y; iy++) {
-            int visible_column_index = address2(aon::Int2(ix, iy), aon::Int2(vld.size.x, vld.size.y));
+            settings.set_num_threads(candidates[c], candidates[c]);
 
-            aon::Int2 offset(ix - field_lower_bound.x, iy - field_lower_bound.y);
+            Execution_Scope scope(settings, learn_enabled);
+
+            std::vector<double> step_times(num_steps);
 
-            for (int vc = 0; vc < vld.size.z; vc++) {
-                int wi = std::get<2>(pos) + hidden_size.z * (offset.y + diam * (offset.x + diam * (vc + vld.size.z * hidden_column_index)));
+            // step -1 warms up the OpenMP team and is not timed
+            for (int t = -1; t < num_steps; t++) {
+                for (int i = 0; i < num_io; i++) {
+                    int num_columns = inputs[i].size() / num_steps;
 
-                view(vc + vld.size.z * (offset.y + diam * offset.x)) = vl.weights[wi];
+                    c_inputs[i] = aon::Int_Buffer_View(inputs[i].data() + static_cast<long long>(aon::max(0, t)) * num_columns, num_columns);
+                }
+
+                double start_time = Step_Profiler::now();
+
+                target.step(c_inputs, learn_enabled, 0.0f, 0.0f);
+
+                if (t >= 0)
+                    step_times[t] = Step_Profiler::now() - start_time;
             }
+
+            std::nth_element(step_times.begin(), step_times.begin() + num_steps / 2, step_times.end());
+
+            times[c] = step_times[num_steps / 2];
         }
+    };
 
-    std::tuple<int, int, int> field_size(diam, diam, vld.size.z);
+    std::vector<double> learn_times;
+    std::vector<double> infer_times;
 
-    return std::make_tuple(field, field_size);
+    // inference leaves the weights alone, so it is timed on the live model with its state parked
+    {
+        Vector_Writer parked(m.state_size());
+
+        m.write_state(parked);
+
+        {
+            Params_Scope params_scope(this);
+
+            Busy_Guard guard(owner);
+
+            py::gil_scoped_release release;
+
+            time_candidates(m, false, infer_times);
+        }
+
+        Vector_Reader reader(parked.buffer);
+
+        m.read_state(reader);
+    }
+
+    // learning changes the weights, so it needs a scratch copy of the whole model
+    if (learn) {
+        aon::Hierarchy scratch = m;
+
+        scratch.params = own_params();
+
+        py::gil_scoped_release release;
+
+        time_candidates(scratch, true, learn_times);
+    }
+
+    int best_infer = std::min_element(infer_times.begin(), infer_times.end()) - infer_times.begin();
+    int best_learn = (learn ? std::min_element(learn_times.begin(), learn_times.end()) - learn_times.begin() : -1);
+
+    int num_threads_learn = (learn ? candidates[best_learn] : execution.get_num_threads(true));
+
+    execution.set_num_threads(num_threads_learn, candidates[best_infer]);
+
+    py::dict learn_result;
+    py::dict infer_result;
+
+    for (int c = 0; c < candidates.size(); c++) {
+        if (learn)
+            learn_result[py::int_(candidates[c])] = learn_times[c];
+
+        infer_result[py::int_(candidates[c])] = infer_times[c];
+    }
+
+    py::dict result;
+
+    result["num_threads_learn"] = num_threads_learn;
+    result["num_threads_infer"] = candidates[best_infer];
+    result["learn_step_times"] = learn_result;
+    result["infer_step_times"] = infer_result;
+
+    return result;
+}
+
+void Hierarchy::set_params(
+    const aon::Hierarchy::Params &params
+) {
+    aon::Hierarchy::Params &current = get_params();
+
+    // element-wise, assigning the arrays would reallocate them under references handed out by get_params
+    copy_params(params, current);
+}
+
+std::tuple<py::array_t<unsigned char>, std::tuple<int, int, int>> Hierarchy::get_encoder_receptive_field(
+    int l,
+    int vli,
+    const std::tuple<int, int, int> &pos
+) {
+    int num_layers = get_num_layers();
+
+    if (l < 0 || l >= num_layers)
+        throw std::runtime_error("layer index " + std::to_string(l) + " out of range [0, " + std::to_string(num_layers - 1) + "]!");
+
+    int num_visible_layers = get_num_encoder_visible_layers(l);
+
+    if (vli < 0 || vli >= num_visible_layers)
+        throw std::runtime_error("visible layer index " + std::to_string(vli) + " out of range [0, " + std::to_string(num_visible_layers - 1) + "]!");
+
+    // a pending indexed file reads only the section of this encoder
+    const Hierarchy_Meta* meta = get_pending_meta();
+
+    if (meta != nullptr && !meta->encoder_layouts.empty() && meta->encoder_layouts[l][vli].weights_offset >= 0) {
+        const Hierarchy* owner = root();
+
+        const Encoder_Visible_Layout &layout = meta->encoder_layouts[l][vli];
+
+        const Container_Section &section = find_section(owner->pending_sections, "enc" + std::to_string(l));
+
+        std::tuple<py::array_t<unsigned char>, std::tuple<int, int, int>> result;
+
+        read_section(owner->pending_file->get_data(), section, -1, [&](Memory_Reader &reader) {
+            if (layout.weights_offset > reader.size)
+                throw std::runtime_error("error: corrupted meta section (weights offset past the end of \"" + section.name + "\")!");
+
+            result = encoder_receptive_field(meta->hidden_sizes[l], layout.size, layout.radius,
+                reader.data + layout.weights_offset, reader.size - layout.weights_offset, pos);
+        });
+
+        return result;
+    }
+
+    const aon::Encoder &enc = model().get_encoder(l);
+
+    const aon::Encoder::Visible_Layer &vl = enc.get_visible_layer(vli);
+    const aon::Encoder::Visible_Layer_Desc &vld = enc.get_visible_layer_desc(vli);
+
+    return encoder_receptive_field(enc.get_hidden_size(), vld.size, vld.radius,
+        reinterpret_cast<const unsigned char*>(&vl.weights[0]), vl.weights.size(), pos);
 }
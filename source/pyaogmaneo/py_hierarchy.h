@@ -9,6 +9,9 @@
 #pragma once
 
 #include "py_helpers.h"
+#include "py_async_save.h"
+#include "py_execution.h"
+#include "py_container.h"
 #include <aogmaneo/hierarchy.h>
 
 namespace py = pybind11;
@@ -20,6 +23,23 @@ enum IO_Type {
     action = 2
 };
 
+// layout of one encoder visible layer as recorded in the meta section of indexed files
+struct Encoder_Visible_Layout {
+    aon::Int3 size;
+    int radius;
+
+    long long weights_offset; // within the "enc<l>" section, -1 if not known
+};
+
+// structure recorded in the meta section of indexed files, enough to answer structure queries without loading the model
+struct Hierarchy_Meta {
+    std::vector<aon::Int3> io_sizes;
+    std::vector<int> io_types;
+    std::vector<aon::Int3> hidden_sizes;
+
+    std::vector<std::vector<Encoder_Visible_Layout>> encoder_layouts; // empty for files written before it was recorded
+};
+
 struct IO_Desc {
     std::tuple<int, int, int> size;
     IO_Type type;
@@ -84,20 +104,266 @@ struct Layer_Desc {
     void check_in_range() const;
 };
 
-struct Params {
-    std::vector<aon::Hierarchy::Layer_Params> layers;
-    std::vector<aon::Hierarchy::IO_Params> ios;
+// Params is bound directly onto the live aon::Hierarchy::Params, so edits apply without any per-step copy
+// copies src into dst element-wise, so references into dst stay valid, throws if the lengths of ios or layers differ
+void copy_params(
+    const aon::Hierarchy::Params &src,
+    aon::Hierarchy::Params &dst
+);
+
+// layers and ios are returned as lists of references into the params, their lengths are fixed once non-empty
+py::list get_params_layers(
+    const py::object &params
+);
+
+void set_params_layers(
+    aon::Hierarchy::Params &params,
+    const std::vector<aon::Hierarchy::Layer_Params> &layers
+);
+
+py::list get_params_ios(
+    const py::object &params
+);
+
+void set_params_ios(
+    aon::Hierarchy::Params &params,
+    const std::vector<aon::Hierarchy::IO_Params> &ios
+);
+
+// weights staged by Hierarchy::stage_weights_from_buffer
+// shared by the root, the background thread building the standby model, and the handles on it
+struct Weights_Stage {
+    std::mutex mutex;
+    std::condition_variable cond;
+
+    bool finished; // standby is built, or error is set
+    bool applied; // swapped into the live model
+    std::string error;
+
+    std::unique_ptr<aon::Hierarchy> standby; // full model with the staged weights and a cleared state
+
+    Weights_Stage()
+    :
+    finished(false),
+    applied(false)
+    {}
+};
+
+// handle on weights staged by stage_weights_from_buffer, the only place their errors are reported
+class Stage_Handle {
+private:
+    std::shared_ptr<Weights_Stage> stage;
+
+public:
+    Stage_Handle(
+        const std::shared_ptr<Weights_Stage> &stage
+    )
+    :
+    stage(stage)
+    {}
+
+    // blocks (with the GIL released) until the staged weights are built, rethrows read errors
+    void wait();
+
+    bool done() const {
+        std::lock_guard<std::mutex> lock(stage->mutex);
+
+        return stage->finished;
+    }
+
+    // whether they replaced the weights of the model, false while pending, after an error, or if staged over
+    bool applied() const {
+        std::lock_guard<std::mutex> lock(stage->mutex);
 
-    bool anticipation;
+        return stage->applied;
+    }
 };
 
-class Hierarchy {
+class Hierarchy : public View_Owner {
 private:
-    aon::Hierarchy h;
+    friend class Hierarchy_Pool;
+    friend class Action_Decoder;
+
+    // behind a pointer, so staged weights are swapped in without copying (see swap_staged_weights)
+    std::unique_ptr<aon::Hierarchy> h;
 
-    aon::Array<aon::Int_Buffer> c_input_cis_backing;
     aon::Array<aon::Int_Buffer_View> c_input_cis;
 
+    // sampling scratch and random stream, independent of aon::global_state
+    mutable aon::Float_Buffer sample_scratch;
+    mutable std::uint64_t sample_state;
+
+    enum Profile_Section {
+        profile_inputs = 0, // validation and input views
+        profile_core_step = 1, // aon::Hierarchy::step, with the GIL released
+        profile_outputs = 2, // copying out predictions (step_sequence only)
+        profile_total = 3
+    };
+
+    Step_Profiler profiler;
+
+    Execution_Settings execution;
+
+    // copy-on-write forks share the model (weights) of their root, states and params are per instance
+    // the root's h holds the state of whichever instance is active, the others are parked as serialized state
+    Hierarchy* fork_parent; // root this is a fork of, nullptr if this owns its model
+    py::object fork_parent_ref; // keeps the root alive
+    std::vector<Hierarchy*> forks; // live forks of this root
+    Hierarchy* active; // instance whose state is loaded in h (roots only)
+    std::vector<unsigned char> parked_state;
+
+    // params of this instance, swapped into the model around its steps and writes (Params_Scope)
+    // kept outside the model, so references handed out by get_params survive swapping in staged weights
+    aon::Hierarchy::Params instance_params;
+
+    // frozen roots reject weight writes, so their forks can hold many inference sessions against one copy of the weights
+    bool frozen;
+    std::vector<unsigned char> session_state; // cleared state new sessions start from, captured on freeze
+
+    // set while an instance sharing h runs with the GIL released (roots only)
+    // written with the GIL and busy_mutex held, read with either held
+    bool busy;
+    std::mutex busy_mutex;
+    std::condition_variable busy_cond;
+
+    struct Busy_Guard {
+        Hierarchy* owner;
+
+        Busy_Guard(
+            Hierarchy* owner
+        )
+        :
+        owner(owner)
+        {
+            std::lock_guard<std::mutex> lock(owner->busy_mutex);
+
+            owner->busy = true;
+        }
+
+        ~Busy_Guard() {
+            {
+                std::lock_guard<std::mutex> lock(owner->busy_mutex);
+
+                owner->busy = false;
+            }
+
+            owner->busy_cond.notify_all();
+        }
+    };
+
+    // waits (with the GIL released) until no instance sharing the model is mid-step on another thread (roots only)
+    // returns with the GIL held and busy clear, so the caller may use the model until it next releases the GIL
+    void wait_idle();
+
+    // indexed container whose sections are read on first use (roots only)
+    std::unique_ptr<Mapped_File> pending_file;
+    std::vector<Container_Section> pending_sections;
+    Hierarchy_Meta pending_meta;
+
+    void load_pending();
+
+    // weight hot-swap (roots only), see stage_weights_from_buffer
+    std::shared_ptr<Weights_Stage> weights_stage;
+
+    Hierarchy();
+
+    Hierarchy* root() const {
+        return (fork_parent != nullptr ? fork_parent : const_cast<Hierarchy*>(this));
+    }
+
+    // the model with this instance's state loaded, swapping it in if a fork sharing the model was used last
+    // if another instance sharing the model is mid-step on another thread, waits for it first
+    aon::Hierarchy &model() const {
+        Hierarchy* owner = root();
+
+        if (owner->pending_file != nullptr || owner->active != this) {
+            owner->wait_idle();
+
+            if (owner->pending_file != nullptr)
+                owner->load_pending();
+
+            if (owner->active != this)
+                owner->swap_state_in(const_cast<Hierarchy*>(this));
+        }
+
+        return *owner->h;
+    }
+
+    // structure of the pending indexed file, so structure queries do not load the model, nullptr once loaded
+    const Hierarchy_Meta* get_pending_meta() const {
+        const Hierarchy* owner = root();
+
+        return (owner->pending_file != nullptr ? &owner->pending_meta : nullptr);
+    }
+
+    const aon::Hierarchy::Params &own_params() const {
+        // a pending file sets them when loaded
+        if (fork_parent == nullptr)
+            model();
+
+        return instance_params;
+    }
+
+    // copy = false views alive on this instance and every instance sharing its model
+    int get_num_model_views() const;
+
+    // throws if a copy = false view is alive on this instance or on any instance sharing its model
+    void check_no_model_views(
+        const std::string &method
+    ) const;
+
+    // throws for copy = false views on a model shared with forks or sessions, since its buffers hold whichever state is swapped in
+    void check_view_allowed(
+        bool copy,
+        const py::object &out
+    ) const;
+
+    // exchanges instance_params with the params of the shared model, element-wise so nothing is reallocated
+    void swap_params();
+
+    // puts an instance's params in effect for the duration of its step or write
+    struct Params_Scope {
+        Hierarchy* instance;
+
+        Params_Scope(
+            Hierarchy* instance
+        )
+        :
+        instance(instance)
+        {
+            instance->swap_params();
+        }
+
+        ~Params_Scope() {
+            instance->swap_params();
+        }
+    };
+
+    std::unique_ptr<Hierarchy> new_fork(
+        std::vector<unsigned char> &&state
+    ) const;
+
+    void swap_state_in(
+        Hierarchy* next
+    );
+
+    void release_fork(
+        Hierarchy* fork
+    );
+
+    void materialize_forks();
+
+    // before anything that modifies the shared model, forks take a private copy and roots detach their forks
+    void prepare_write() {
+        if (root()->frozen)
+            throw std::runtime_error("error: the weights of this hierarchy are frozen! step with learn_enabled = False, or unfreeze the root first");
+
+        if (fork_parent != nullptr)
+            materialize();
+        else if (!forks.empty())
+            materialize_forks();
+    }
+
     void init_random(
         const std::vector<IO_Desc> &io_descs,
         const std::vector<Layer_Desc> &layer_descs
@@ -108,76 +374,281 @@ private:
     );
 
     void init_from_buffer(
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
-    void copy_params_to_h();
+    void sample_prediction_into(
+        int i,
+        float temperature,
+        std::uint64_t base_state,
+        int* sample
+    ) const;
 
 public:
-    Params params;
-
     Hierarchy(
         const std::vector<IO_Desc> &io_descs,
         const std::vector<Layer_Desc> &layer_descs,
         const std::string &file_name,
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
+    // deep copy, forks of other are not carried over
+    Hierarchy(
+        const Hierarchy &other
+    );
+
+    Hierarchy &operator=(
+        const Hierarchy &other
+    ) = delete;
+
+    ~Hierarchy();
+
+    // cheap clone for rollouts, only the current state and params are copied, the weights stay shared with this (or its root)
+    // learning on the fork (or the root) and set_weights_from_buffer make a private copy of the weights first
+    // steps of a fork and the instances it shares with run one at a time, a step waits while another is mid-step on another thread
+    std::unique_ptr<Hierarchy> fork() const;
+
+    // gives a fork its own copy of the model, does nothing on instances that already own theirs
+    void materialize();
+
+    bool is_fork() const {
+        return fork_parent != nullptr;
+    }
+
+    // freezes (or unfreezes) the weights of the root this shares its model with
+    // while frozen, learning and weight loads throw instead of copying the model
+    // params are not frozen, they are per instance, so editing a session's params affects only that session
+    void set_frozen(
+        bool frozen
+    );
+
+    bool is_frozen() const {
+        return root()->frozen;
+    }
+
+    // per-session inference state against the frozen shared weights, starting from a cleared state
+    // memory per session is about get_state_size() bytes, stepping a session swaps its state into the shared model
+    // (a full state copy in and out per switch), and sessions of one root step one at a time, so they save memory, not time
+    std::unique_ptr<Hierarchy> create_session() const;
+
+    // compress = true writes the compressed container, which every load function detects by its header
+    // indexed = true writes an indexed container with checksummed sections: "meta" (the structure and encoder layouts),
+    // "struct" (the model stream with the weights and state arrays left out as zero runs), "state", and the weights,
+    // one section per encoder ("enc<l>"), first layer decoder ("dec0_<i>" per prediction IO) or actor ("act<i>" per action IO),
+    // and higher layer decoder ("dec<l>"), compress = true compresses each of these
+    // the live model is only read while saving
+    // loading an indexed file only validates its index and meta, the sections are read on first use, structure getters and
+    // get_encoder_receptive_field are answered from the meta section (and the one "enc<l>" section) until then
     void save_to_file(
+        const std::string &file_name,
+        bool compress,
+        bool indexed
+    );
+
+    // reads the structure of a saved hierarchy from the meta section of an indexed file, without loading the model
+    static py::dict read_file_info(
         const std::string &file_name
     );
 
+    bool is_loaded() const {
+        return root()->pending_file == nullptr;
+    }
+
+    // reads only the named sections of an indexed file ("state", "enc<l>", "dec0_<i>", "act<i>", "dec<l>", or "weights"), see read_file_info
+    // into this instance, which must have the structure they were saved from, weights sections are written as by set_weights_from_buffer
+    void load_sections_from_file(
+        const std::string &file_name,
+        const std::vector<std::string> &sections
+    );
+
+    // snapshots synchronously, then writes (and optionally compresses) on a background thread
+    // the file appears atomically once complete, a crash mid-write leaves any previous file intact
+    Save_Handle save_to_file_async(
+        const std::string &file_name,
+        bool compress
+    );
+
     void set_state_from_buffer(
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
     void set_weights_from_buffer(
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
-    py::array_t<unsigned char> serialize_to_buffer();
+    // copies the weights (as from serialize_weights_to_buffer, optionally compressed), and on a background thread
+    // decompresses and checks them and builds a standby model holding them, the live model keeps stepping meanwhile
+    // the next step (or swap_staged_weights) moves the active state over (O(state)) and swaps the models, keeping the params
+    // applies to the root, so forks and sessions sharing the model switch too, and frozen roots may be updated this way
+    // costs a second full model while staged, read errors are reported through the returned handle only
+    Stage_Handle stage_weights_from_buffer(
+        const py::buffer &buffer
+    );
+
+    bool has_staged_weights() const {
+        return root()->weights_stage != nullptr;
+    }
+
+    // swaps in staged weights, wait = False returns False instead of waiting if they are still being built
+    // or another instance sharing the model is being stepped
+    // returns False and drops them if they failed (see Stage_Handle.wait), the live weights are left as they were
+    // while copy = False views of the model are alive, the weights are copied in place instead (O(weights)), keeping the views valid
+    bool swap_staged_weights(
+        bool wait
+    );
+
+    py::array_t<unsigned char> serialize_to_buffer(
+        bool compress
+    );
 
     py::array_t<unsigned char> serialize_state_to_buffer();
 
-    py::array_t<unsigned char> serialize_weights_to_buffer();
+    py::array_t<unsigned char> serialize_weights_to_buffer(
+        bool compress
+    );
 
-    long get_size() const {
-        return h.size();
+    // state delta against a base from serialize_state_to_buffer, holding only the blocks that changed since
+    py::array_t<unsigned char> serialize_state_delta(
+        const py::buffer &base
+    );
+
+    // restores the state of base with delta applied
+    void apply_state_delta(
+        const py::buffer &base,
+        const py::buffer &delta
+    );
+
+    // every instance edits its own copy, the shared model is untouched
+    aon::Hierarchy::Params &get_params() {
+        // a pending file sets them when loaded
+        if (fork_parent == nullptr)
+            model();
+
+        return instance_params;
     }
 
-    long get_state_size() const {
-        return h.state_size();
+    void set_params(
+        const aon::Hierarchy::Params &params
+    );
+
+    long long get_size() const {
+        return model().size();
     }
 
-    long get_weights_size() const {
-        return h.weights_size();
+    long long get_state_size() const {
+        return model().state_size();
     }
 
+    long long get_weights_size() const {
+        return model().weights_size();
+    }
+
+    // releases the GIL while stepping, so different instances can be stepped from different Python threads in parallel
+    // a single instance must not be used from multiple threads at the same time
+    // validate = false skips the column index bounds check, for trusted producers only
     void step(
         const std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> &input_cis,
         bool learn_enabled,
         float reward,
-        float mimic
+        float mimic,
+        bool validate
+    );
+
+    // steps over a whole sequence natively with the GIL released
+    // input_cis are (T, num_columns) per IO, rewards and mimics are (T,) or scalars
+    // returns a list of (T, num_columns) predictions per IO (None for IOs without a decoder or actor)
+    // with capture_hidden, returns a tuple (predictions, hidden_cis) with (T, num_hidden_columns) per layer
+    py::object step_sequence(
+        const std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> &input_cis,
+        bool learn_enabled,
+        const py::array_t<float, py::array::c_style | py::array::forcecast> &rewards,
+        const py::array_t<float, py::array::c_style | py::array::forcecast> &mimics,
+        bool capture_hidden,
+        bool validate
+    );
+
+    // opt-in coarse step timing, costs one branch per step when disabled
+    // sections are only inputs (validation and views), core_step (the whole aon::Hierarchy::step), outputs and total,
+    // the core has no per-layer step calls to time separately, so this shows binding overhead against core time, not
+    // which layer is slow
+    void set_profiling(
+        bool enabled,
+        int window_size
+    ) {
+        profiler.set_enabled(enabled, window_size);
+    }
+
+    bool get_profiling() const {
+        return profiler.is_enabled();
+    }
+
+    void reset_step_profile() {
+        profiler.reset();
+    }
+
+    py::dict get_step_profile() const {
+        return profiler.get_profile();
+    }
+
+    // per-instance thread count (0 = global setting) and cpus to pin the stepping thread and its OpenMP team to (Linux only)
+    // first_touch rereads the model from a thread pinned to cpus, so the buffers reallocated by the read land on their NUMA node
+    // (for forks and sessions this moves the shared model), throws while copy = False views of the shared model are alive
+    void set_execution(
+        int num_threads,
+        const std::vector<int> &cpus,
+        bool first_touch
+    );
+
+    // returns (num_threads_learn, num_threads_infer, cpus)
+    std::tuple<int, int, std::vector<int>> get_execution() const {
+        return std::make_tuple(execution.get_num_threads(true), execution.get_num_threads(false), execution.get_cpus());
+    }
+
+    // times num_steps steps per candidate thread count (powers of 2 up to max_threads, 0 = hardware threads),
+    // and keeps the fastest in the execution settings, for inference and (learn = true) for learning
+    // inference is timed on the live model with its state parked and restored, costing one state copy
+    // learning is timed on a scratch copy of the model, so peak memory is about twice the model size, learn = false skips it
+    // and keeps the current learning thread count
+    // the weights, state and params are left untouched, the steps draw from aon::global_state like any other step
+    // returns a dict with the chosen counts and the median step time per thread count
+    py::dict autotune(
+        int num_steps,
+        int max_threads,
+        bool learn
     );
 
     void clear_state() {
-        h.clear_state();
+        model().clear_state();
     }
 
+    // structure getters answer from the meta section while an indexed file is pending
     int get_num_layers() const {
-        return h.get_num_layers();
+        const Hierarchy_Meta* meta = get_pending_meta();
+
+        if (meta != nullptr)
+            return meta->hidden_sizes.size();
+
+        return model().get_num_layers();
     }
 
+    // getters copy by default, see buffer_to_numpy for the copy = false and out modes
+    // copy = false is refused on forks, sessions and roots that have them, and fork/create_session refuse while views are alive
     py::array_t<int> get_prediction_cis(
-        int i
+        int i,
+        bool copy,
+        const py::object &out
     ) const;
 
     py::array_t<int> get_layer_prediction_cis(
-        int l
+        int l,
+        bool copy,
+        const py::object &out
     ) const;
 
     py::array_t<float> get_prediction_acts(
-        int i
+        int i,
+        bool copy,
+        const py::object &out
     ) const;
 
     py::array_t<int> sample_prediction(
@@ -185,17 +656,26 @@ public:
         float temperature
     ) const;
 
+    // samples every IO in one call, temperatures are per IO, None is returned for IOs without a decoder or actor
+    std::vector<py::object> sample_predictions(
+        const std::vector<float> &temperatures
+    ) const;
+
     py::array_t<int> get_hidden_cis(
-        int l
-    );
+        int l,
+        bool copy,
+        const py::object &out
+    ) const;
 
     std::tuple<int, int, int> get_hidden_size(
         int l
     ) {
-        if (l < 0 || l >= h.get_num_layers())
+        if (l < 0 || l >= get_num_layers())
             throw std::runtime_error("error: " + std::to_string(l) + " is not a valid layer index!");
 
-        aon::Int3 size = h.get_encoder(l).get_hidden_size();
+        const Hierarchy_Meta* meta = get_pending_meta();
+
+        aon::Int3 size = (meta != nullptr ? meta->hidden_sizes[l] : model().get_encoder(l).get_hidden_size());
 
         return { size.x, size.y, size.z };
     }
@@ -203,23 +683,35 @@ public:
     int get_num_encoder_visible_layers(
         int l
     ) {
-        if (l < 0 || l >= h.get_num_layers())
+        if (l < 0 || l >= get_num_layers())
             throw std::runtime_error("error: " + std::to_string(l) + " is not a valid layer index!");
 
-        return h.get_num_encoder_visible_layers(l);
+        const Hierarchy_Meta* meta = get_pending_meta();
+
+        if (meta != nullptr && !meta->encoder_layouts.empty())
+            return meta->encoder_layouts[l].size();
+
+        return model().get_num_encoder_visible_layers(l);
     }
 
     int get_num_io() const {
-        return h.get_num_io();
+        const Hierarchy_Meta* meta = get_pending_meta();
+
+        if (meta != nullptr)
+            return meta->io_sizes.size();
+
+        return model().get_num_io();
     }
 
     std::tuple<int, int, int> get_io_size(
         int i
     ) const {
-        if (i < 0 || i >= h.get_num_io())
+        if (i < 0 || i >= get_num_io())
             throw std::runtime_error("error: " + std::to_string(i) + " is not a valid input index!");
 
-        aon::Int3 size = h.get_io_size(i);
+        const Hierarchy_Meta* meta = get_pending_meta();
+
+        aon::Int3 size = (meta != nullptr ? meta->io_sizes[i] : model().get_io_size(i));
 
         return { size.x, size.y, size.z };
     }
@@ -227,36 +719,43 @@ public:
     IO_Type get_io_type(
         int i
     ) const {
-        if (i < 0 || i >= h.get_num_io())
+        if (i < 0 || i >= get_num_io())
             throw std::runtime_error("error: " + std::to_string(i) + " is not a valid input index!");
 
-        return static_cast<IO_Type>(h.get_io_type(i));
+        const Hierarchy_Meta* meta = get_pending_meta();
+
+        return static_cast<IO_Type>(meta != nullptr ? meta->io_types[i] : model().get_io_type(i));
     }
 
     // retrieve additional parameters on the sph's structure
     int get_up_radius(
         int l
     ) const {
-        if (l < 0 || l >= h.get_num_layers())
+        if (l < 0 || l >= get_num_layers())
             throw std::runtime_error("error: " + std::to_string(l) + " is not a valid layer index!");
 
-        return h.get_encoder(l).get_visible_layer_desc(0).radius;
+        const Hierarchy_Meta* meta = get_pending_meta();
+
+        if (meta != nullptr && !meta->encoder_layouts.empty() && !meta->encoder_layouts[l].empty())
+            return meta->encoder_layouts[l][0].radius;
+
+        return model().get_encoder(l).get_visible_layer_desc(0).radius;
     }
 
     int get_down_radius(
         int l,
         int i
     ) const {
-        if (l < 0 || l >= h.get_num_layers())
+        if (l < 0 || l >= model().get_num_layers())
             throw std::runtime_error("error: " + std::to_string(l) + " is not a valid layer index!");
 
-        if (l == 0 && i < 0 || i >= h.get_num_io())
+        if (l == 0 && i < 0 || i >= model().get_num_io())
             throw std::runtime_error("error: " + std::to_string(i) + " is not a valid input index!");
 
-        if (h.get_io_type(i) == aon::action)
-            return h.get_actor(i).get_visible_layer_desc(0).radius;
+        if (model().get_io_type(i) == aon::action)
+            return model().get_actor(i).get_visible_layer_desc(0).radius;
         
-        return h.get_decoder(l, i).get_visible_layer_desc(0).radius;
+        return model().get_decoder(l, i).get_visible_layer_desc(0).radius;
     }
 
     std::tuple<py::array_t<unsigned char>, std::tuple<int, int, int>> get_encoder_receptive_field(
@@ -0,0 +1,204 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "py_hierarchy_pool.h"
+
+using namespace pyaon;
+
+Hierarchy_Pool::Hierarchy_Pool(
+    int num_hierarchies,
+    const Hierarchy &hierarchy
+)
+:
+params_dirty(false)
+{
+    if (num_hierarchies < 1)
+        throw std::runtime_error("error: num_hierarchies < 1 is not allowed!");
+
+    hs.resize(num_hierarchies);
+
+    for (int j = 0; j < hs.size(); j++) {
+        hs[j] = hierarchy.model();
+
+        hs[j].params = hierarchy.own_params();
+    }
+
+    c_input_cis.resize(num_hierarchies);
+
+    for (int j = 0; j < c_input_cis.size(); j++)
+        c_input_cis[j].resize(hs[0].get_num_io());
+}
+
+void Hierarchy_Pool::step(
+    const std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> &input_cis,
+    bool learn_enabled,
+    const py::array_t<float, py::array::c_style | py::array::forcecast> &rewards,
+    const py::array_t<float, py::array::c_style | py::array::forcecast> &mimics
+) {
+    int num_hierarchies = hs.size();
+
+    if (input_cis.size() != hs[0].get_num_io())
+        throw std::runtime_error("incorrect number of input_cis passed to step! received " + std::to_string(input_cis.size()) + ", need " + std::to_string(hs[0].get_num_io()));
+
+    if (rewards.size() != 1 && rewards.size() != num_hierarchies)
+        throw std::runtime_error("incorrect number of rewards passed to step! received " + std::to_string(rewards.size()) + ", need 1 or " + std::to_string(num_hierarchies));
+
+    if (mimics.size() != 1 && mimics.size() != num_hierarchies)
+        throw std::runtime_error("incorrect number of mimics passed to step! received " + std::to_string(mimics.size()) + ", need 1 or " + std::to_string(num_hierarchies));
+
+    if (params_dirty)
+        copy_params_to_hs();
+
+    for (int i = 0; i < input_cis.size(); i++) {
+        aon::Int3 io_size = hs[0].get_io_size(i);
+
+        int num_columns = io_size.x * io_size.y;
+
+        if (input_cis[i].ndim() != 2 || input_cis[i].shape(0) != num_hierarchies || input_cis[i].shape(1) != num_columns)
+            throw std::runtime_error("incorrect csdr shape at index " + std::to_string(i) + " - expected (" + std::to_string(num_hierarchies) + ", " + std::to_string(num_columns) + ")");
+
+        const int* data = input_cis[i].data();
+
+        if (!cis_in_range(data, input_cis[i].size(), io_size.z)) {
+            // slow path, only to report the offending column
+            for (long long j = 0; j < input_cis[i].size(); j++) {
+                if (data[j] < 0 || data[j] >= io_size.z)
+                    throw std::runtime_error("input csdr at input index " + std::to_string(i) + " has an out-of-bounds column index (" + std::to_string(data[j]) + ") at hierarchy " + std::to_string(j / num_columns) + ", column index " + std::to_string(j % num_columns) + ". it must be in the range [0, " + std::to_string(io_size.z - 1) + "]");
+            }
+        }
+
+        // view rows of the stacked array directly, it outlives the step
+        for (int j = 0; j < num_hierarchies; j++)
+            c_input_cis[j][i] = aon::Int_Buffer_View(const_cast<int*>(data + j * num_columns), num_columns);
+    }
+
+    const float* rewards_data = rewards.data();
+    const float* mimics_data = mimics.data();
+
+    int reward_stride = (rewards.size() == 1 ? 0 : 1);
+    int mimic_stride = (mimics.size() == 1 ? 0 : 1);
+
+    py::gil_scoped_release release;
+
+    // members are stepped concurrently, the loops inside each step then run on the thread stepping it (nested regions are inactive)
+    // the few draws each step makes from aon::global_state interleave between members, so pool steps are not reproducible
+    #pragma omp parallel for
+    for (int j = 0; j < num_hierarchies; j++)
+        hs[j].step(c_input_cis[j], learn_enabled, rewards_data[j * reward_stride], mimics_data[j * mimic_stride]);
+}
+
+void Hierarchy_Pool::clear_state() {
+    for (int j = 0; j < hs.size(); j++)
+        hs[j].clear_state();
+}
+
+py::array_t<int> Hierarchy_Pool::get_prediction_cis(
+    int i
+) const {
+    if (i < 0 || i >= hs[0].get_num_io())
+        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(hs[0].get_num_io() - 1) + "]!");
+
+    if (!hs[0].io_layer_exists(i) || hs[0].get_io_type(i) == aon::none)
+        throw std::runtime_error("no decoder exists at index " + std::to_string(i) + " - did you set it to the correct type?");
+
+    int num_columns = hs[0].get_prediction_cis(i).size();
+
+    py::array_t<int> predictions({ hs.size(), num_columns });
+
+    auto view = predictions.mutable_unchecked<2>();
+
+    for (int j = 0; j < hs.size(); j++) {
+        const aon::Int_Buffer &cis = hs[j].get_prediction_cis(i);
+
+        for (int k = 0; k < num_columns; k++)
+            view(j, k) = cis[k];
+    }
+
+    return predictions;
+}
+
+py::array_t<float> Hierarchy_Pool::get_prediction_acts(
+    int i
+) const {
+    if (i < 0 || i >= hs[0].get_num_io())
+        throw std::runtime_error("prediction index " + std::to_string(i) + " out of range [0, " + std::to_string(hs[0].get_num_io() - 1) + "]!");
+
+    if (!hs[0].io_layer_exists(i) || hs[0].get_io_type(i) == aon::none)
+        throw std::runtime_error("no decoder or actor exists at index " + std::to_string(i) + " - did you set it to the correct type?");
+
+    int num_cells = hs[0].get_prediction_acts(i).size();
+
+    py::array_t<float> predictions({ hs.size(), num_cells });
+
+    auto view = predictions.mutable_unchecked<2>();
+
+    for (int j = 0; j < hs.size(); j++) {
+        const aon::Float_Buffer &acts = hs[j].get_prediction_acts(i);
+
+        for (int k = 0; k < num_cells; k++)
+            view(j, k) = acts[k];
+    }
+
+    return predictions;
+}
+
+py::array_t<int> Hierarchy_Pool::get_hidden_cis(
+    int l
+) const {
+    if (l < 0 || l >= hs[0].get_num_layers())
+        throw std::runtime_error("error: " + std::to_string(l) + " is not a valid layer index!");
+
+    int num_columns = hs[0].get_encoder(l).get_hidden_cis().size();
+
+    py::array_t<int> hidden_cis({ hs.size(), num_columns });
+
+    auto view = hidden_cis.mutable_unchecked<2>();
+
+    for (int j = 0; j < hs.size(); j++) {
+        const aon::Int_Buffer &cis = hs[j].get_encoder(l).get_hidden_cis();
+
+        for (int k = 0; k < num_columns; k++)
+            view(j, k) = cis[k];
+    }
+
+    return hidden_cis;
+}
+
+Hierarchy Hierarchy_Pool::get_hierarchy(
+    int index
+) const {
+    if (index < 0 || index >= hs.size())
+        throw std::runtime_error("hierarchy index " + std::to_string(index) + " out of range [0, " + std::to_string(hs.size() - 1) + "]!");
+
+    Buffer_Writer writer(hs[index].size() + sizeof(int));
+
+    hs[index].write(writer);
+
+    Hierarchy h(std::vector<IO_Desc>(), std::vector<Layer_Desc>(), std::string(), writer.buffer);
+
+    h.instance_params = hs[0].params;
+
+    return h;
+}
+
+void Hierarchy_Pool::set_params(
+    const aon::Hierarchy::Params &params
+) {
+    // element-wise, so references handed out by get_params stay valid
+    copy_params(params, hs[0].params);
+
+    params_dirty = true;
+}
+
+void Hierarchy_Pool::copy_params_to_hs() {
+    // the lengths match so nothing is reallocated
+    for (int j = 1; j < hs.size(); j++)
+        copy_params(hs[0].params, hs[j].params);
+
+    params_dirty = false;
+}
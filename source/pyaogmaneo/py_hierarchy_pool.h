@@ -0,0 +1,102 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "py_hierarchy.h"
+
+namespace py = pybind11;
+
+namespace pyaon {
+// N independent hierarchies of identical structure, stepped together in one call, meant for many vectorized environments
+// saves the per-hierarchy Python dispatch, input conversion and GIL round trip
+// members are stepped concurrently, one per OpenMP thread, which suits many small hierarchies
+// they all draw from the shared aon::global_state, so results are not reproducible, even after set_global_state
+class Hierarchy_Pool {
+private:
+    aon::Array<aon::Hierarchy> hs;
+
+    aon::Array<aon::Array<aon::Int_Buffer_View>> c_input_cis;
+
+    // set when params may have changed (assigned, or handed out for editing), cleared once copied to the other members
+    bool params_dirty;
+
+    void copy_params_to_hs();
+
+public:
+    Hierarchy_Pool(
+        int num_hierarchies,
+        const Hierarchy &hierarchy
+    );
+
+    // params are bound to the first hierarchy and copied to the others on the next step after they were accessed or assigned
+    // edits through a params object kept from before the last step are not seen, access pool.params again instead
+    aon::Hierarchy::Params &get_params() {
+        params_dirty = true;
+
+        return hs[0].params;
+    }
+
+    void set_params(
+        const aon::Hierarchy::Params &params
+    );
+
+    int get_num_hierarchies() const {
+        return hs.size();
+    }
+
+    // input_cis are (num_hierarchies, num_columns) per IO, rewards and mimics are (num_hierarchies,) or scalars
+    void step(
+        const std::vector<py::array_t<int, py::array::c_style | py::array::forcecast>> &input_cis,
+        bool learn_enabled,
+        const py::array_t<float, py::array::c_style | py::array::forcecast> &rewards,
+        const py::array_t<float, py::array::c_style | py::array::forcecast> &mimics
+    );
+
+    void clear_state();
+
+    int get_num_layers() const {
+        return hs[0].get_num_layers();
+    }
+
+    int get_num_io() const {
+        return hs[0].get_num_io();
+    }
+
+    std::tuple<int, int, int> get_io_size(
+        int i
+    ) const {
+        if (i < 0 || i >= hs[0].get_num_io())
+            throw std::runtime_error("error: " + std::to_string(i) + " is not a valid input index!");
+
+        aon::Int3 size = hs[0].get_io_size(i);
+
+        return { size.x, size.y, size.z };
+    }
+
+    // (num_hierarchies, num_columns)
+    py::array_t<int> get_prediction_cis(
+        int i
+    ) const;
+
+    // (num_hierarchies, num_columns * column_size)
+    py::array_t<float> get_prediction_acts(
+        int i
+    ) const;
+
+    // (num_hierarchies, num_hidden_columns)
+    py::array_t<int> get_hidden_cis(
+        int l
+    ) const;
+
+    // copy of a single member of the pool
+    Hierarchy get_hierarchy(
+        int index
+    ) const;
+};
+}
@@ -7,6 +7,9 @@
 // ----------------------------------------------------------------------------
 
 #include "py_image_encoder.h"
+#include "py_compression.h"
+
+#include <cmath>
 
 using namespace pyaon;
 
@@ -24,13 +27,129 @@ void Image_Visible_Layer_Desc::check_in_range() const {
         throw std::runtime_error("error: radius < 0 is not allowed!");
 }
 
+// source indices and weights per output index along one axis of a resample
+// downscaling uses area (box) filtering, so every source pixel contributes by coverage and fine detail does not alias,
+// upscaling (and equal sizes) uses bilinear interpolation
+struct Resample_Axis {
+    std::vector<int> starts;
+    std::vector<int> counts;
+    std::vector<int> offsets; // into weights
+    std::vector<float> weights;
+
+    Resample_Axis(
+        int src_size,
+        int dst_size
+    )
+    :
+    starts(dst_size),
+    counts(dst_size),
+    offsets(dst_size)
+    {
+        float ratio = static_cast<float>(src_size) / static_cast<float>(dst_size);
+
+        for (int o = 0; o < dst_size; o++) {
+            offsets[o] = weights.size();
+
+            if (src_size > dst_size) {
+                // footprint [lo, hi) of the output pixel in source pixels
+                float lo = o * ratio;
+                float hi = aon::min(static_cast<float>(src_size), (o + 1) * ratio);
+
+                int first = static_cast<int>(lo);
+                int last = aon::min(src_size - 1, static_cast<int>(std::ceil(hi)) - 1);
+
+                float ratio_inv = 1.0f / ratio;
+
+                for (int s = first; s <= last; s++)
+                    weights.push_back(aon::max(0.0f, aon::min(hi, s + 1.0f) - aon::max(lo, static_cast<float>(s))) * ratio_inv);
+
+                starts[o] = first;
+                counts[o] = last - first + 1;
+            }
+            else {
+                float s = aon::min(static_cast<float>(src_size - 1), aon::max(0.0f, (o + 0.5f) * ratio - 0.5f));
+
+                int s0 = static_cast<int>(s);
+
+                float w = s - s0;
+
+                starts[o] = s0;
+
+                if (s0 + 1 < src_size) {
+                    weights.push_back(1.0f - w);
+                    weights.push_back(w);
+
+                    counts[o] = 2;
+                }
+                else {
+                    weights.push_back(1.0f);
+
+                    counts[o] = 1;
+                }
+            }
+        }
+    }
+};
+
+// resample of an (src_rows, src_cols, channels) image into (dst_rows, dst_cols, channels) bytes, mapping [low, high] to [0, 255]
+// area filtered along axes that shrink, bilinear along the others (see Resample_Axis)
+// normalization is affine, so it is applied after filtering
+template<typename T>
+static void resample_image(
+    const T* src,
+    int src_rows,
+    int src_cols,
+    int channels,
+    unsigned char* dst,
+    int dst_rows,
+    int dst_cols,
+    float low,
+    float high
+) {
+    float scale = 255.0f / (high - low);
+
+    // column tables are shared by all rows
+    Resample_Axis rows(src_rows, dst_rows);
+    Resample_Axis cols(src_cols, dst_cols);
+
+    #pragma omp parallel for
+    for (int ox = 0; ox < dst_rows; ox++) {
+        const float* row_weights = &rows.weights[rows.offsets[ox]];
+
+        unsigned char* dst_row = dst + static_cast<long long>(ox) * dst_cols * channels;
+
+        for (int oy = 0; oy < dst_cols; oy++) {
+            const float* col_weights = &cols.weights[cols.offsets[oy]];
+
+            for (int c = 0; c < channels; c++) {
+                float v = 0.0f;
+
+                for (int r = 0; r < rows.counts[ox]; r++) {
+                    const T* src_pixels = src + (static_cast<long long>(rows.starts[ox] + r) * src_cols + cols.starts[oy]) * channels + c;
+
+                    float row_v = 0.0f;
+
+                    for (int k = 0; k < cols.counts[oy]; k++)
+                        row_v += col_weights[k] * src_pixels[k * channels];
+
+                    v += row_weights[r] * row_v;
+                }
+
+                v = (v - low) * scale;
+
+                dst_row[c + oy * channels] = static_cast<unsigned char>(aon::min(255.0f, aon::max(0.0f, v)) + 0.5f);
+            }
+        }
+    }
+}
+
 Image_Encoder::Image_Encoder(
     const std::tuple<int, int, int> &hidden_size,
     const std::vector<Image_Visible_Layer_Desc> &visible_layer_descs,
     const std::string &file_name,
-    const py::array_t<unsigned char> &buffer
+    const py::buffer &buffer
 ) {
-    if (buffer.unchecked().size() > 0)
+    if (get_buffer_size(buffer) > 0)
         init_from_buffer(buffer);
     else if (!file_name.empty())
         init_from_file(file_name);
@@ -41,9 +160,6 @@ Image_Encoder::Image_Encoder(
         init_random(hidden_size, visible_layer_descs);
     }
 
-    // copy params
-    params = enc.params;
-
     c_inputs_backing.resize(enc.get_num_visible_layers());
     c_inputs.resize(enc.get_num_visible_layers());
 
@@ -84,53 +200,76 @@ void Image_Encoder::init_random(
 void Image_Encoder::init_from_file(
     const std::string &file_name
 ) {
-    File_Reader reader;
-    reader.ins.open(file_name, std::ios::binary);
-
-    enc.read(reader);
+    read_file_maybe_compressed(file_name, [this](aon::Stream_Reader &reader) {
+        enc.read(reader);
+    });
 }
 
 void Image_Encoder::init_from_buffer(
-    const py::array_t<unsigned char> &buffer
+    const py::buffer &buffer
 ) {
-    Buffer_Reader reader;
-    reader.buffer = &buffer;
-
-    enc.read(reader);
+    read_maybe_compressed(buffer, [this](aon::Stream_Reader &reader) {
+        enc.read(reader);
+    });
 }
 
 void Image_Encoder::save_to_file(
-    const std::string &file_name
+    const std::string &file_name,
+    bool compress
 ) {
+    if (compress) {
+        Buffer_Writer writer(enc.size() + sizeof(int));
+
+        enc.write(writer);
+
+        save_compressed_to_file(file_name, writer.data, writer.start);
+
+        return;
+    }
+
     File_Writer writer;
     writer.outs.open(file_name, std::ios::binary);
 
     enc.write(writer);
 }
 
-void Image_Encoder::set_state_from_buffer(
-    const py::array_t<unsigned char> &buffer
+Save_Handle Image_Encoder::save_to_file_async(
+    const std::string &file_name,
+    bool compress
 ) {
-    Buffer_Reader reader;
-    reader.buffer = &buffer;
+    Vector_Writer writer(enc.size() + sizeof(int));
+
+    enc.write(writer);
 
-    enc.read_state(reader);
+    return Save_Handle(file_name, std::move(writer.buffer), compress);
 }
 
-void Image_Encoder::set_weights_from_buffer(
-    const py::array_t<unsigned char> &buffer
+void Image_Encoder::set_state_from_buffer(
+    const py::buffer &buffer
 ) {
-    Buffer_Reader reader;
-    reader.buffer = &buffer;
+    read_maybe_compressed(buffer, [this](aon::Stream_Reader &reader) {
+        enc.read_state(reader);
+    });
+}
 
-    enc.read_weights(reader);
+void Image_Encoder::set_weights_from_buffer(
+    const py::buffer &buffer
+) {
+    read_maybe_compressed(buffer, [this](aon::Stream_Reader &reader) {
+        enc.read_weights(reader);
+    });
 }
 
-py::array_t<unsigned char> Image_Encoder::serialize_to_buffer() {
+py::array_t<unsigned char> Image_Encoder::serialize_to_buffer(
+    bool compress
+) {
     Buffer_Writer writer(enc.size() + sizeof(int));
 
     enc.write(writer);
 
+    if (compress)
+        return compress_buffer(writer.data, writer.start);
+
     return writer.buffer;
 }
 
@@ -142,11 +281,16 @@ py::array_t<unsigned char> Image_Encoder::serialize_state_to_buffer() {
     return writer.buffer;
 }
 
-py::array_t<unsigned char> Image_Encoder::serialize_weights_to_buffer() {
+py::array_t<unsigned char> Image_Encoder::serialize_weights_to_buffer(
+    bool compress
+) {
     Buffer_Writer writer(enc.weights_size());
 
     enc.write_weights(writer);
 
+    if (compress)
+        return compress_buffer(writer.data, writer.start);
+
     return writer.buffer;
 }
 
@@ -158,9 +302,6 @@ void Image_Encoder::step(
     if (inputs.size() != enc.get_num_visible_layers())
         throw std::runtime_error("incorrect number of inputs given to Image_Encoder! expected " + std::to_string(enc.get_num_visible_layers()) + ", got " + std::to_string(inputs.size()));
 
-    // copy params
-    enc.params = params;
-
     for (int i = 0; i < inputs.size(); i++) {
         auto view = inputs[i].unchecked();
 
@@ -173,9 +314,165 @@ void Image_Encoder::step(
         c_inputs[i] = c_inputs_backing[i];
     }
 
+    // inputs are copied, no Python objects are touched past this point
+    py::gil_scoped_release release;
+
+    Execution_Scope scope(execution, learn_enabled);
+
     enc.step(c_inputs, learn_enabled, learn_recon);
 }
 
+void Image_Encoder::step_images(
+    const std::vector<py::array> &images,
+    float low,
+    float high,
+    bool learn_enabled,
+    bool learn_recon
+) {
+    if (images.size() != enc.get_num_visible_layers())
+        throw std::runtime_error("incorrect number of images given to Image_Encoder! expected " + std::to_string(enc.get_num_visible_layers()) + ", got " + std::to_string(images.size()));
+
+    if (high <= low)
+        throw std::runtime_error("error: high must be greater than low!");
+
+    // contiguous (possibly converted) images, kept alive until the step is done
+    std::vector<py::array> sources(images.size());
+
+    for (int i = 0; i < images.size(); i++) {
+        const aon::Int3 &size = enc.get_visible_layer_desc(i).size;
+
+        int channels = (images[i].ndim() == 3 ? images[i].shape(2) : 1);
+
+        if ((images[i].ndim() != 2 && images[i].ndim() != 3) || images[i].shape(0) < 1 || images[i].shape(1) < 1)
+            throw std::runtime_error("image at input index " + std::to_string(i) + " must be (H, W, C) or (H, W)!");
+
+        if (channels != size.z)
+            throw std::runtime_error("image at input index " + std::to_string(i) + " has " + std::to_string(channels) + " channels, expected " + std::to_string(size.z));
+
+        // uint8 stays uint8, everything else is processed as float32
+        if (images[i].dtype().is(py::dtype::of<unsigned char>()))
+            sources[i] = py::array_t<unsigned char, py::array::c_style | py::array::forcecast>::ensure(images[i]);
+        else
+            sources[i] = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(images[i]);
+
+        if (!sources[i])
+            throw std::runtime_error("image at input index " + std::to_string(i) + " could not be converted to uint8 or float32!");
+    }
+
+    std::vector<bool> is_bytes(sources.size());
+    std::vector<const void*> sources_data(sources.size());
+    std::vector<int> src_rows(sources.size());
+    std::vector<int> src_cols(sources.size());
+
+    for (int i = 0; i < sources.size(); i++) {
+        is_bytes[i] = sources[i].dtype().is(py::dtype::of<unsigned char>());
+        sources_data[i] = sources[i].data();
+        src_rows[i] = sources[i].shape(0);
+        src_cols[i] = sources[i].shape(1);
+    }
+
+    py::gil_scoped_release release;
+
+    Execution_Scope scope(execution, learn_enabled);
+
+    for (int i = 0; i < sources.size(); i++) {
+        const aon::Int3 &size = enc.get_visible_layer_desc(i).size;
+
+        if (is_bytes[i])
+            resample_image(static_cast<const unsigned char*>(sources_data[i]), src_rows[i], src_cols[i], size.z, &c_inputs_backing[i][0], size.x, size.y, low, high);
+        else
+            resample_image(static_cast<const float*>(sources_data[i]), src_rows[i], src_cols[i], size.z, &c_inputs_backing[i][0], size.x, size.y, low, high);
+
+        c_inputs[i] = c_inputs_backing[i];
+    }
+
+    enc.step(c_inputs, learn_enabled, learn_recon);
+}
+
+py::array_t<int> Image_Encoder::step_batch(
+    const std::vector<py::array_t<unsigned char, py::array::c_style | py::array::forcecast>> &frames,
+    bool learn_enabled,
+    bool learn_recon
+) {
+    if (frames.size() != enc.get_num_visible_layers())
+        throw std::runtime_error("incorrect number of frame arrays given to Image_Encoder! expected " + std::to_string(enc.get_num_visible_layers()) + ", got " + std::to_string(frames.size()));
+
+    if (frames[0].ndim() < 2)
+        throw std::runtime_error("frames given to step_batch must be at least 2D (T, ...)!");
+
+    int num_frames = frames[0].shape(0);
+
+    std::vector<const unsigned char*> frames_data(frames.size());
+
+    for (int i = 0; i < frames.size(); i++) {
+        int num_inputs = c_inputs_backing[i].size();
+
+        if (frames[i].ndim() < 2 || frames[i].shape(0) != num_frames || frames[i].size() != static_cast<long long>(num_frames) * num_inputs)
+            throw std::runtime_error("incorrect frame shape given to Image_Encoder at input index " + std::to_string(i) + "! expected (" + std::to_string(num_frames) + ", " + std::to_string(num_inputs) + ")");
+
+        frames_data[i] = frames[i].data();
+    }
+
+    int num_hidden_columns = enc.get_hidden_cis().size();
+
+    py::array_t<int> hidden_cis({ num_frames, num_hidden_columns });
+
+    int* hidden_cis_data = hidden_cis.mutable_data();
+
+    {
+        py::gil_scoped_release release;
+
+        Execution_Scope scope(execution, learn_enabled);
+
+        for (int t = 0; t < num_frames; t++) {
+            // view each frame in place, no copy
+            for (int i = 0; i < frames_data.size(); i++) {
+                int num_inputs = c_inputs_backing[i].size();
+
+                c_inputs[i] = aon::Byte_Buffer_View(const_cast<unsigned char*>(frames_data[i] + static_cast<long long>(t) * num_inputs), num_inputs);
+            }
+
+            enc.step(c_inputs, learn_enabled, learn_recon);
+
+            std::memcpy(hidden_cis_data + static_cast<long long>(t) * num_hidden_columns, &enc.get_hidden_cis()[0], num_hidden_columns * sizeof(int));
+        }
+    }
+
+    return hidden_cis;
+}
+
+void Image_Encoder::set_execution(
+    int num_threads,
+    const std::vector<int> &cpus,
+    bool first_touch
+) {
+    execution.set(num_threads, cpus);
+
+    if (!first_touch || cpus.empty())
+        return;
+
+    check_no_views("set_execution(first_touch=True)");
+
+    aon::Image_Encoder::Params params = enc.params;
+
+    {
+        py::gil_scoped_release release;
+
+        // reallocates every buffer of the encoder, see Hierarchy::set_execution
+        execution.run_pinned([this]() {
+            Vector_Writer writer(enc.size() + sizeof(int));
+
+            enc.write(writer);
+
+            Vector_Reader reader(writer.buffer);
+
+            enc.read(reader);
+        });
+    }
+
+    enc.params = params;
+}
+
 void Image_Encoder::reconstruct(
     const py::array_t<int, py::array::c_style | py::array::forcecast> &recon_cis
 ) {
@@ -197,30 +494,21 @@ void Image_Encoder::reconstruct(
 }
 
 py::array_t<unsigned char> Image_Encoder::get_reconstruction(
-    int i
+    int i,
+    bool copy,
+    const py::object &out
 ) const {
     if (i < 0 || i >= enc.get_num_visible_layers())
         throw std::runtime_error("cannot get reconstruction at index " + std::to_string(i) + " - out of bounds [0, " + std::to_string(enc.get_num_visible_layers()) + "]");
 
-    py::array_t<unsigned char> reconstruction(enc.get_reconstruction(i).size());
-
-    auto view = reconstruction.mutable_unchecked();
-
-    for (int j = 0; j < view.size(); j++)
-        view(j) = enc.get_reconstruction(i)[j];
-
-    return reconstruction;
+    return buffer_to_numpy(enc.get_reconstruction(i), copy, out, this);
 }
 
-py::array_t<int> Image_Encoder::get_hidden_cis() const {
-    py::array_t<int> hidden_cis(enc.get_hidden_cis().size());
-
-    auto view = hidden_cis.mutable_unchecked();
-
-    for (int j = 0; j < view.size(); j++)
-        view(j) = enc.get_hidden_cis()[j];
-
-    return hidden_cis;
+py::array_t<int> Image_Encoder::get_hidden_cis(
+    bool copy,
+    const py::object &out
+) const {
+    return buffer_to_numpy(enc.get_hidden_cis(), copy, out, this);
 }
 
 std::tuple<py::array_t<unsigned char>, std::tuple<int, int, int>> Image_Encoder::get_receptive_field(
@@ -285,10 +573,10 @@ std::tuple<py::array_t<unsigned char>, std::tuple<int, int, int>> Image_Encoder:
 
             aon::Int2 offset(ix - field_lower_bound.x, iy - field_lower_bound.y);
 
-            int wi_start_partial = vld.size.z * (offset.y + diam * (offset.x + diam * hidden_column_index));
+            long long wi_start_partial = vld.size.z * (offset.y + diam * (offset.x + diam * static_cast<long long>(hidden_column_index)));
 
             for (int vc = 0; vc < vld.size.z; vc++) {
-                int wi = std::get<2>(pos) + hidden_size.z * (vc + wi_start_partial);
+                long long wi = std::get<2>(pos) + hidden_size.z * (vc + wi_start_partial);
 
                 view(vc + vld.size.z * (offset.y + diam * offset.x)) = vl.weights[wi];
             }
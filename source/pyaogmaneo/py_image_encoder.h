@@ -9,6 +9,8 @@
 #pragma once
 
 #include "py_helpers.h"
+#include "py_async_save.h"
+#include "py_execution.h"
 #include <aogmaneo/image_encoder.h>
 
 namespace py = pybind11;
@@ -31,13 +33,15 @@ struct Image_Visible_Layer_Desc {
     void check_in_range() const;
 };
 
-class Image_Encoder {
+class Image_Encoder : public View_Owner {
 private:
     aon::Image_Encoder enc;
 
     aon::Array<aon::Byte_Buffer> c_inputs_backing;
     aon::Array<aon::Byte_Buffer_View> c_inputs;
 
+    Execution_Settings execution;
+
     void init_random(
         const std::tuple<int, int, int> &hidden_size,
         const std::vector<Image_Visible_Layer_Desc> &visible_layer_descs
@@ -48,55 +52,110 @@ private:
     );
 
     void init_from_buffer(
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
 public:
-    aon::Image_Encoder::Params params;
-
     Image_Encoder(
         const std::tuple<int, int, int> &hidden_size,
         const std::vector<Image_Visible_Layer_Desc> &visible_layer_descs,
         const std::string &file_name,
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
+    // compress = true writes the compressed container, which every load function detects by its header
     void save_to_file(
-        const std::string &file_name
+        const std::string &file_name,
+        bool compress
+    );
+
+    // snapshots synchronously, then writes (and optionally compresses) on a background thread
+    // the file appears atomically once complete, a crash mid-write leaves any previous file intact
+    Save_Handle save_to_file_async(
+        const std::string &file_name,
+        bool compress
     );
 
     void set_state_from_buffer(
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
     void set_weights_from_buffer(
-        const py::array_t<unsigned char> &buffer
+        const py::buffer &buffer
     );
 
-    py::array_t<unsigned char> serialize_to_buffer();
+    py::array_t<unsigned char> serialize_to_buffer(
+        bool compress
+    );
 
     py::array_t<unsigned char> serialize_state_to_buffer();
 
-    py::array_t<unsigned char> serialize_weights_to_buffer();
+    py::array_t<unsigned char> serialize_weights_to_buffer(
+        bool compress
+    );
+
+    // bound directly onto the live encoder params, so no per-step copy is needed
+    aon::Image_Encoder::Params &get_params() {
+        return enc.params;
+    }
 
-    long get_size() const {
+    void set_params(
+        const aon::Image_Encoder::Params &params
+    ) {
+        enc.params = params;
+    }
+
+    long long get_size() const {
         return enc.size();
     }
 
-    long get_state_size() const {
+    long long get_state_size() const {
         return enc.state_size();
     }
 
-    long get_weights_size() const {
+    long long get_weights_size() const {
         return enc.weights_size();
     }
 
+    // releases the GIL while stepping, so different instances can be stepped from different Python threads in parallel
+    // a single instance must not be used from multiple threads at the same time
     void step(
         const std::vector<py::array_t<unsigned char, py::array::c_style | py::array::forcecast>> &inputs,
         bool learn_enabled,
         bool learn_recon
     );
 
+    // fused preprocessing and step: takes (H, W, C) or (H, W) uint8 or float32 images of any resolution per visible layer
+    // normalizes [low, high] to [0, 255] and resamples straight into the encoder inputs (area filtered when downscaling, else bilinear)
+    void step_images(
+        const std::vector<py::array> &images,
+        float low,
+        float high,
+        bool learn_enabled,
+        bool learn_recon
+    );
+
+    // encodes T frames natively with the GIL released, frames are (T, ...) per visible layer (e.g. np.memmap of recorded video)
+    // returns the (T, num_hidden_columns) hidden CSDRs
+    py::array_t<int> step_batch(
+        const std::vector<py::array_t<unsigned char, py::array::c_style | py::array::forcecast>> &frames,
+        bool learn_enabled,
+        bool learn_recon
+    );
+
+    // per-instance thread count (0 = global setting) and cpus to pin the stepping thread and its OpenMP team to (Linux only)
+    // first_touch rereads the encoder from a thread pinned to cpus, so the buffers reallocated by the read land on their NUMA node
+    // throws while copy = False views of the encoder are alive
+    void set_execution(
+        int num_threads,
+        const std::vector<int> &cpus,
+        bool first_touch
+    );
+
+    std::tuple<int, std::vector<int>> get_execution() const {
+        return std::make_tuple(execution.get_num_threads(true), execution.get_cpus());
+    }
+
     void reconstruct(
         const py::array_t<int, py::array::c_style | py::array::forcecast> &recon_cis
     );
@@ -105,11 +164,17 @@ public:
         return enc.get_num_visible_layers();
     }
 
+    // getters copy by default, see buffer_to_numpy for the copy = false and out modes
     py::array_t<unsigned char> get_reconstruction(
-        int i
+        int i,
+        bool copy,
+        const py::object &out
     ) const;
 
-    py::array_t<int> get_hidden_cis() const;
+    py::array_t<int> get_hidden_cis(
+        bool copy,
+        const py::object &out
+    ) const;
 
     std::tuple<int, int, int> get_hidden_size() const {
         aon::Int3 size = enc.get_hidden_size();
@@ -7,11 +7,17 @@
 // ----------------------------------------------------------------------------
 
 #include "py_hierarchy.h"
+#include "py_hierarchy_pool.h"
+#include "py_action_decoder.h"
 #include "py_image_encoder.h"
+#include "py_scalar_encoder.h"
 
 namespace py = pybind11;
 
 PYBIND11_MODULE(pyaogmaneo, m) {
+    // pending async saves and weight staging finish before the interpreter exits
+    py::module_::import("atexit").attr("register")(py::cpp_function(&pyaon::wait_background_tasks));
+
     m.def("set_num_threads", &pyaon::set_num_threads);
     m.def("get_num_threads", &pyaon::get_num_threads);
 
@@ -130,31 +136,82 @@ PYBIND11_MODULE(pyaogmaneo, m) {
         .def_readwrite("actor", &aon::Hierarchy::IO_Params::actor)
         .def_readwrite("importance", &aon::Hierarchy::IO_Params::importance);
 
-    py::class_<pyaon::Params>(m, "Params")
+    py::class_<aon::Hierarchy::Params>(m, "Params")
         .def(py::init<>())
-        .def_readwrite("layers", &pyaon::Params::layers)
-        .def_readwrite("ios", &pyaon::Params::ios)
-        .def_readwrite("anticipation", &pyaon::Params::anticipation);
+        .def_property("layers", &pyaon::get_params_layers, &pyaon::set_params_layers)
+        .def_property("ios", &pyaon::get_params_ios, &pyaon::set_params_ios)
+        .def_readwrite("anticipation", &aon::Hierarchy::Params::anticipation);
+
+    py::class_<pyaon::Save_Handle>(m, "SaveHandle")
+        .def("wait", &pyaon::Save_Handle::wait)
+        .def("done", &pyaon::Save_Handle::done);
+
+    py::class_<pyaon::Stage_Handle>(m, "StageHandle")
+        .def("wait", &pyaon::Stage_Handle::wait)
+        .def("done", &pyaon::Stage_Handle::done)
+        .def("applied", &pyaon::Stage_Handle::applied);
 
     py::class_<pyaon::Hierarchy>(m, "Hierarchy")
         .def(py::init<
                 const std::vector<pyaon::IO_Desc>&,
                 const std::vector<pyaon::Layer_Desc>&,
                 const std::string&,
-                const py::array_t<unsigned char>&
+                const py::buffer&
             >(),
             py::arg("io_descs") = std::vector<pyaon::IO_Desc>(),
             py::arg("layer_descs") = std::vector<pyaon::Layer_Desc>(),
             py::arg("file_name") = std::string(),
-            py::arg("buffer") = py::array_t<unsigned char>()
+            py::arg("buffer") = py::bytes()
+        )
+        .def_property("params", &pyaon::Hierarchy::get_params, &pyaon::Hierarchy::set_params, py::return_value_policy::reference_internal)
+        .def("save_to_file", &pyaon::Hierarchy::save_to_file,
+            py::arg("file_name"),
+            py::arg("compress") = false,
+            py::arg("indexed") = false
+        )
+        .def_static("read_file_info", &pyaon::Hierarchy::read_file_info,
+            py::arg("file_name")
+        )
+        .def("is_loaded", &pyaon::Hierarchy::is_loaded)
+        .def("load_sections_from_file", &pyaon::Hierarchy::load_sections_from_file,
+            py::arg("file_name"),
+            py::arg("sections")
+        )
+        .def("save_to_file_async", &pyaon::Hierarchy::save_to_file_async,
+            py::arg("file_name"),
+            py::arg("compress") = false
         )
-        .def_readwrite("params", &pyaon::Hierarchy::params)
-        .def("save_to_file", &pyaon::Hierarchy::save_to_file)
         .def("set_state_from_buffer", &pyaon::Hierarchy::set_state_from_buffer)
         .def("set_weights_from_buffer", &pyaon::Hierarchy::set_weights_from_buffer)
-        .def("serialize_to_buffer", &pyaon::Hierarchy::serialize_to_buffer)
+        .def("stage_weights_from_buffer", &pyaon::Hierarchy::stage_weights_from_buffer,
+            py::arg("buffer")
+        )
+        .def("has_staged_weights", &pyaon::Hierarchy::has_staged_weights)
+        .def("swap_staged_weights", &pyaon::Hierarchy::swap_staged_weights,
+            py::arg("wait") = true
+        )
+        .def("serialize_to_buffer", &pyaon::Hierarchy::serialize_to_buffer,
+            py::arg("compress") = false
+        )
         .def("serialize_state_to_buffer", &pyaon::Hierarchy::serialize_state_to_buffer)
-        .def("serialize_weights_to_buffer", &pyaon::Hierarchy::serialize_weights_to_buffer)
+        .def("serialize_weights_to_buffer", &pyaon::Hierarchy::serialize_weights_to_buffer,
+            py::arg("compress") = false
+        )
+        .def("serialize_state_delta", &pyaon::Hierarchy::serialize_state_delta,
+            py::arg("base")
+        )
+        .def("apply_state_delta", &pyaon::Hierarchy::apply_state_delta,
+            py::arg("base"),
+            py::arg("delta")
+        )
+        .def("fork", &pyaon::Hierarchy::fork)
+        .def("materialize", &pyaon::Hierarchy::materialize)
+        .def("is_fork", &pyaon::Hierarchy::is_fork)
+        .def("set_frozen", &pyaon::Hierarchy::set_frozen,
+            py::arg("frozen") = true
+        )
+        .def("is_frozen", &pyaon::Hierarchy::is_frozen)
+        .def("create_session", &pyaon::Hierarchy::create_session)
         .def("get_size", &pyaon::Hierarchy::get_size)
         .def("get_state_size", &pyaon::Hierarchy::get_state_size)
         .def("get_weights_size", &pyaon::Hierarchy::get_weights_size)
@@ -162,15 +219,61 @@ PYBIND11_MODULE(pyaogmaneo, m) {
             py::arg("input_cis"),
             py::arg("learn_enabled") = true,
             py::arg("reward") = 0.0f,
-            py::arg("mimic") = 0.0f
+            py::arg("mimic") = 0.0f,
+            py::arg("validate") = true
+        )
+        .def("step_sequence", &pyaon::Hierarchy::step_sequence,
+            py::arg("input_cis"),
+            py::arg("learn_enabled") = true,
+            py::arg("rewards") = 0.0f,
+            py::arg("mimics") = 0.0f,
+            py::arg("capture_hidden") = false,
+            py::arg("validate") = true
+        )
+        .def("set_profiling", &pyaon::Hierarchy::set_profiling,
+            py::arg("enabled") = true,
+            py::arg("window_size") = 1024
+        )
+        .def("get_profiling", &pyaon::Hierarchy::get_profiling)
+        .def("reset_step_profile", &pyaon::Hierarchy::reset_step_profile)
+        .def("get_step_profile", &pyaon::Hierarchy::get_step_profile)
+        .def("set_execution", &pyaon::Hierarchy::set_execution,
+            py::arg("num_threads") = 0,
+            py::arg("cpus") = std::vector<int>(),
+            py::arg("first_touch") = false
+        )
+        .def("get_execution", &pyaon::Hierarchy::get_execution)
+        .def("autotune", &pyaon::Hierarchy::autotune,
+            py::arg("num_steps") = 16,
+            py::arg("max_threads") = 0,
+            py::arg("learn") = true
         )
         .def("clear_state", &pyaon::Hierarchy::clear_state)
         .def("get_num_layers", &pyaon::Hierarchy::get_num_layers)
-        .def("get_prediction_cis", &pyaon::Hierarchy::get_prediction_cis)
-        .def("get_layer_prediction_cis", &pyaon::Hierarchy::get_layer_prediction_cis)
-        .def("get_prediction_acts", &pyaon::Hierarchy::get_prediction_acts)
+        .def("get_prediction_cis", &pyaon::Hierarchy::get_prediction_cis,
+            py::arg("i"),
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
+        .def("get_layer_prediction_cis", &pyaon::Hierarchy::get_layer_prediction_cis,
+            py::arg("l"),
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
+        .def("get_prediction_acts", &pyaon::Hierarchy::get_prediction_acts,
+            py::arg("i"),
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
         .def("sample_prediction", &pyaon::Hierarchy::sample_prediction)
-        .def("get_hidden_cis", &pyaon::Hierarchy::get_hidden_cis)
+        .def("sample_predictions", &pyaon::Hierarchy::sample_predictions,
+            py::arg("temperatures")
+        )
+        .def("get_hidden_cis", &pyaon::Hierarchy::get_hidden_cis,
+            py::arg("l"),
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
         .def("get_hidden_size", &pyaon::Hierarchy::get_hidden_size)
         .def("get_num_encoder_visible_layers", &pyaon::Hierarchy::get_num_encoder_visible_layers)
         .def("get_num_io", &pyaon::Hierarchy::get_num_io)
@@ -190,6 +293,62 @@ PYBIND11_MODULE(pyaogmaneo, m) {
             }
         );
 
+    py::class_<pyaon::Hierarchy_Pool>(m, "HierarchyPool")
+        .def(py::init<
+                int,
+                const pyaon::Hierarchy&
+            >(),
+            py::arg("num_hierarchies"),
+            py::arg("hierarchy")
+        )
+        .def_property("params", &pyaon::Hierarchy_Pool::get_params, &pyaon::Hierarchy_Pool::set_params, py::return_value_policy::reference_internal)
+        .def("get_num_hierarchies", &pyaon::Hierarchy_Pool::get_num_hierarchies)
+        .def("step", &pyaon::Hierarchy_Pool::step,
+            py::arg("input_cis"),
+            py::arg("learn_enabled") = true,
+            py::arg("rewards") = 0.0f,
+            py::arg("mimics") = 0.0f
+        )
+        .def("clear_state", &pyaon::Hierarchy_Pool::clear_state)
+        .def("get_num_layers", &pyaon::Hierarchy_Pool::get_num_layers)
+        .def("get_num_io", &pyaon::Hierarchy_Pool::get_num_io)
+        .def("get_io_size", &pyaon::Hierarchy_Pool::get_io_size)
+        .def("get_prediction_cis", &pyaon::Hierarchy_Pool::get_prediction_cis)
+        .def("get_prediction_acts", &pyaon::Hierarchy_Pool::get_prediction_acts)
+        .def("get_hidden_cis", &pyaon::Hierarchy_Pool::get_hidden_cis)
+        .def("get_hierarchy", &pyaon::Hierarchy_Pool::get_hierarchy);
+
+    py::class_<pyaon::Action_Decoder>(m, "ActionDecoder")
+        .def(py::init<
+                const pyaon::Hierarchy&,
+                int,
+                const std::vector<float>&,
+                const std::vector<float>&
+            >(),
+            py::arg("hierarchy"),
+            py::arg("io_index"),
+            py::arg("lows") = std::vector<float>(),
+            py::arg("highs") = std::vector<float>()
+        )
+        .def("decode", &pyaon::Action_Decoder::decode,
+            py::arg("hierarchy"),
+            py::arg("epsilon") = 0.0f,
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
+        .def("randomize", &pyaon::Action_Decoder::randomize)
+        .def("set_actions", &pyaon::Action_Decoder::set_actions)
+        .def("get_actions", &pyaon::Action_Decoder::get_actions,
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
+        .def("get_values", &pyaon::Action_Decoder::get_values,
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
+        .def("get_io_index", &pyaon::Action_Decoder::get_io_index)
+        .def("get_num_values", &pyaon::Action_Decoder::get_num_values);
+
     py::class_<pyaon::Image_Visible_Layer_Desc>(m, "ImageVisibleLayerDesc")
         .def(py::init<
                 std::tuple<int, int, int>,
@@ -215,20 +374,31 @@ PYBIND11_MODULE(pyaogmaneo, m) {
                 const std::tuple<int, int, int>&,
                 const std::vector<pyaon::Image_Visible_Layer_Desc>&,
                 const std::string&,
-                const py::array_t<unsigned char>&
+                const py::buffer&
             >(),
             py::arg("hidden_size") = std::tuple<int, int, int>({ 5, 5, 16 }),
             py::arg("visible_layer_descs") = std::vector<pyaon::Image_Visible_Layer_Desc>(),
             py::arg("file_name") = std::string(),
-            py::arg("buffer") = py::array_t<unsigned char>()
+            py::arg("buffer") = py::bytes()
+        )
+        .def_property("params", &pyaon::Image_Encoder::get_params, &pyaon::Image_Encoder::set_params, py::return_value_policy::reference_internal)
+        .def("save_to_file", &pyaon::Image_Encoder::save_to_file,
+            py::arg("file_name"),
+            py::arg("compress") = false
+        )
+        .def("save_to_file_async", &pyaon::Image_Encoder::save_to_file_async,
+            py::arg("file_name"),
+            py::arg("compress") = false
         )
-        .def_readwrite("params", &pyaon::Image_Encoder::params)
-        .def("save_to_file", &pyaon::Image_Encoder::save_to_file)
         .def("set_state_from_buffer", &pyaon::Image_Encoder::set_state_from_buffer)
         .def("set_weights_from_buffer", &pyaon::Image_Encoder::set_weights_from_buffer)
-        .def("serialize_to_buffer", &pyaon::Image_Encoder::serialize_to_buffer)
+        .def("serialize_to_buffer", &pyaon::Image_Encoder::serialize_to_buffer,
+            py::arg("compress") = false
+        )
         .def("serialize_state_to_buffer", &pyaon::Image_Encoder::serialize_state_to_buffer)
-        .def("serialize_weights_to_buffer", &pyaon::Image_Encoder::serialize_weights_to_buffer)
+        .def("serialize_weights_to_buffer", &pyaon::Image_Encoder::serialize_weights_to_buffer,
+            py::arg("compress") = false
+        )
         .def("get_size", &pyaon::Image_Encoder::get_size)
         .def("get_state_size", &pyaon::Image_Encoder::get_state_size)
         .def("get_weights_size", &pyaon::Image_Encoder::get_weights_size)
@@ -237,10 +407,35 @@ PYBIND11_MODULE(pyaogmaneo, m) {
             py::arg("learn_enabled") = true,
             py::arg("learn_recon") = false
         )
+        .def("step_images", &pyaon::Image_Encoder::step_images,
+            py::arg("images"),
+            py::arg("low") = 0.0f,
+            py::arg("high") = 255.0f,
+            py::arg("learn_enabled") = true,
+            py::arg("learn_recon") = false
+        )
+        .def("step_batch", &pyaon::Image_Encoder::step_batch,
+            py::arg("frames"),
+            py::arg("learn_enabled") = true,
+            py::arg("learn_recon") = false
+        )
+        .def("set_execution", &pyaon::Image_Encoder::set_execution,
+            py::arg("num_threads") = 0,
+            py::arg("cpus") = std::vector<int>(),
+            py::arg("first_touch") = false
+        )
+        .def("get_execution", &pyaon::Image_Encoder::get_execution)
         .def("reconstruct", &pyaon::Image_Encoder::reconstruct)
         .def("get_num_visible_layers", &pyaon::Image_Encoder::get_num_visible_layers)
-        .def("get_reconstruction", &pyaon::Image_Encoder::get_reconstruction)
-        .def("get_hidden_cis", &pyaon::Image_Encoder::get_hidden_cis)
+        .def("get_reconstruction", &pyaon::Image_Encoder::get_reconstruction,
+            py::arg("i"),
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
+        .def("get_hidden_cis", &pyaon::Image_Encoder::get_hidden_cis,
+            py::arg("copy") = true,
+            py::arg("out") = py::none()
+        )
         .def("get_hidden_size", &pyaon::Image_Encoder::get_hidden_size)
         .def("get_visible_size", &pyaon::Image_Encoder::get_visible_size)
         .def("get_receptive_field", &pyaon::Image_Encoder::get_receptive_field)
@@ -254,4 +449,45 @@ PYBIND11_MODULE(pyaogmaneo, m) {
                 return other;
             }
         );
+    // not exported, the value names are too generic for the module namespace
+    py::enum_<pyaon::Scalar_Encoding>(m, "ScalarEncoding")
+        .value("linear", pyaon::scalar_linear)
+        .value("sigmoid", pyaon::scalar_sigmoid)
+        .value("multi_scale", pyaon::scalar_multi_scale)
+        .value("ieee", pyaon::scalar_ieee);
+
+    py::class_<pyaon::Scalar_Encoder>(m, "ScalarEncoder")
+        .def(py::init<
+                int,
+                int,
+                pyaon::Scalar_Encoding,
+                float,
+                float,
+                float,
+                int,
+                float,
+                int
+            >(),
+            py::arg("num_values"),
+            py::arg("column_size"),
+            py::arg("encoding") = pyaon::scalar_sigmoid,
+            py::arg("low") = -1.0f,
+            py::arg("high") = 1.0f,
+            py::arg("sensitivity") = 1.0f,
+            py::arg("num_scales") = 4,
+            py::arg("scale_factor") = 0.25f,
+            py::arg("num_columns") = 0
+        )
+        .def("encode", &pyaon::Scalar_Encoder::encode,
+            py::arg("values"),
+            py::arg("out") = py::none()
+        )
+        .def("decode", &pyaon::Scalar_Encoder::decode,
+            py::arg("cis")
+        )
+        .def("get_columns_per_value", &pyaon::Scalar_Encoder::get_columns_per_value)
+        .def("get_num_values", &pyaon::Scalar_Encoder::get_num_values)
+        .def("get_column_size", &pyaon::Scalar_Encoder::get_column_size)
+        .def("get_num_columns", &pyaon::Scalar_Encoder::get_num_columns)
+        .def("get_encoding", &pyaon::Scalar_Encoder::get_encoding);
 }
@@ -0,0 +1,236 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#include "py_scalar_encoder.h"
+
+#include <cmath>
+
+using namespace pyaon;
+
+Scalar_Encoder::Scalar_Encoder(
+    int num_values,
+    int column_size,
+    Scalar_Encoding encoding,
+    float low,
+    float high,
+    float sensitivity,
+    int num_scales,
+    float scale_factor,
+    int num_columns
+)
+:
+encoding(encoding),
+num_values(num_values),
+column_size(column_size),
+low(low),
+high(high),
+sensitivity(sensitivity),
+num_scales(num_scales),
+scale_factor(scale_factor)
+{
+    if (num_values < 1)
+        throw std::runtime_error("error: num_values < 1 is not allowed!");
+
+    if (column_size < 2)
+        throw std::runtime_error("error: column_size < 2 is not allowed!");
+
+    if (encoding == scalar_linear && high <= low)
+        throw std::runtime_error("error: high <= low is not allowed for linear encoding!");
+
+    if (encoding == scalar_sigmoid && sensitivity == 0.0f)
+        throw std::runtime_error("error: sensitivity == 0 is not allowed for sigmoid encoding!");
+
+    if (encoding == scalar_multi_scale && num_scales < 1)
+        throw std::runtime_error("error: num_scales < 1 is not allowed for multi-scale encoding!");
+
+    if (encoding == scalar_ieee && column_size < 16)
+        throw std::runtime_error("error: column_size < 16 is not allowed for IEEE encoding!");
+
+    int num_used_columns = num_values * get_columns_per_value();
+
+    if (num_columns == 0)
+        num_columns = num_used_columns;
+    else if (num_columns < num_used_columns)
+        throw std::runtime_error("error: num_columns (" + std::to_string(num_columns) + ") is less than the " + std::to_string(num_used_columns) + " columns required!");
+
+    this->num_columns = num_columns;
+}
+
+int Scalar_Encoder::get_columns_per_value() const {
+    switch (encoding) {
+    case scalar_multi_scale:
+        return num_scales;
+    case scalar_ieee:
+        return 8;
+    default:
+        return 1;
+    }
+}
+
+py::array_t<int> Scalar_Encoder::encode(
+    const py::array_t<float, py::array::c_style | py::array::forcecast> &values,
+    const py::object &out
+) const {
+    if (values.size() != num_values)
+        throw std::runtime_error("incorrect number of values given to encode! expected " + std::to_string(num_values) + ", got " + std::to_string(values.size()));
+
+    py::array_t<int> cis;
+
+    if (out.is_none())
+        cis = py::array_t<int>(num_columns);
+    else {
+        if (!py::isinstance<py::array_t<int, py::array::c_style>>(out))
+            throw std::runtime_error("error: out must be a C-contiguous numpy array of dtype int32!");
+
+        cis = py::reinterpret_borrow<py::array_t<int>>(out);
+
+        if (cis.size() != num_columns)
+            throw std::runtime_error("error: out has size " + std::to_string(cis.size()) + ", expected " + std::to_string(num_columns) + "!");
+    }
+
+    const float* x = values.data();
+    int* c = cis.mutable_data();
+
+    int num_used_columns = num_values * get_columns_per_value();
+
+    float max_index = column_size - 1;
+
+    switch (encoding) {
+    case scalar_linear: {
+        float scale = 1.0f / (high - low);
+
+        for (int j = 0; j < num_values; j++) {
+            float t = aon::min(1.0f, aon::max(0.0f, (x[j] - low) * scale));
+
+            c[j] = static_cast<int>(t * max_index + 0.5f);
+        }
+
+        break;
+    }
+    case scalar_sigmoid:
+        for (int j = 0; j < num_values; j++) {
+            float t = 1.0f / (1.0f + std::exp(-x[j] * sensitivity));
+
+            c[j] = static_cast<int>(t * max_index + 0.5f);
+        }
+
+        break;
+    case scalar_multi_scale:
+        for (int j = 0; j < num_values; j++) {
+            float v = x[j];
+            float scale = 1.0f;
+
+            for (int s = 0; s < num_scales; s++) {
+                // residual at this scale, in (-1, 1)
+                float r = std::fmod(v / scale, 1.0f);
+
+                int ci = static_cast<int>((r * 0.5f + 0.5f) * max_index + 0.5f);
+
+                c[s + j * num_scales] = ci;
+
+                v -= scale * (ci / max_index * 2.0f - 1.0f);
+
+                scale *= scale_factor;
+            }
+        }
+
+        break;
+    case scalar_ieee:
+        for (int j = 0; j < num_values; j++) {
+            std::uint32_t bits;
+
+            std::memcpy(&bits, &x[j], sizeof(float));
+
+            // little-endian byte order, low nibble first
+            for (int b = 0; b < 4; b++) {
+                std::uint32_t byte = (bits >> (b * 8)) & 0xff;
+
+                c[b * 2 + 0 + j * 8] = byte & 0x0f;
+                c[b * 2 + 1 + j * 8] = byte >> 4;
+            }
+        }
+
+        break;
+    }
+
+    for (int j = num_used_columns; j < num_columns; j++)
+        c[j] = 0;
+
+    return cis;
+}
+
+py::array_t<float> Scalar_Encoder::decode(
+    const py::array_t<int, py::array::c_style | py::array::forcecast> &cis
+) const {
+    int num_used_columns = num_values * get_columns_per_value();
+
+    if (cis.size() < num_used_columns)
+        throw std::runtime_error("incorrect csdr size given to decode! expected at least " + std::to_string(num_used_columns) + " columns, got " + std::to_string(cis.size()));
+
+    const int* c = cis.data();
+
+    if (!cis_in_range(c, num_used_columns, column_size))
+        throw std::runtime_error("csdr given to decode has out-of-bounds column indices, they must be in the range [0, " + std::to_string(column_size - 1) + "]");
+
+    py::array_t<float> values(num_values);
+
+    float* x = values.mutable_data();
+
+    float max_index_inv = 1.0f / (column_size - 1);
+
+    switch (encoding) {
+    case scalar_linear:
+        for (int j = 0; j < num_values; j++)
+            x[j] = low + c[j] * max_index_inv * (high - low);
+
+        break;
+    case scalar_sigmoid: {
+        // keep the logit finite at the ends
+        float epsilon = 0.5f * max_index_inv;
+
+        for (int j = 0; j < num_values; j++) {
+            float t = aon::min(1.0f - epsilon, aon::max(epsilon, c[j] * max_index_inv));
+
+            x[j] = std::log(t / (1.0f - t)) / sensitivity;
+        }
+
+        break;
+    }
+    case scalar_multi_scale:
+        for (int j = 0; j < num_values; j++) {
+            float v = 0.0f;
+            float scale = 1.0f;
+
+            for (int s = 0; s < num_scales; s++) {
+                v += scale * (c[s + j * num_scales] * max_index_inv * 2.0f - 1.0f);
+
+                scale *= scale_factor;
+            }
+
+            x[j] = v;
+        }
+
+        break;
+    case scalar_ieee:
+        for (int j = 0; j < num_values; j++) {
+            std::uint32_t bits = 0;
+
+            for (int b = 0; b < 4; b++) {
+                std::uint32_t byte = (c[b * 2 + 0 + j * 8] & 0x0f) | ((c[b * 2 + 1 + j * 8] & 0x0f) << 4);
+
+                bits |= byte << (b * 8);
+            }
+
+            std::memcpy(&x[j], &bits, sizeof(float));
+        }
+
+        break;
+    }
+
+    return values;
+}
@@ -0,0 +1,81 @@
+// ----------------------------------------------------------------------------
+//  PyAOgmaNeo
+//  Copyright(c) 2020-2025 Ogma Intelligent Systems Corp. All rights reserved.
+//
+//  This copy of PyAOgmaNeo is licensed to you under the terms described
+//  in the PYAOGMANEO_LICENSE.md file included in this distribution.
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include "py_helpers.h"
+
+namespace py = pybind11;
+
+namespace pyaon {
+enum Scalar_Encoding {
+    scalar_linear = 0, // one column per value, [low, high] binned linearly
+    scalar_sigmoid = 1, // one column per value, squashed with a sigmoid (for unbounded values)
+    scalar_multi_scale = 2, // num_scales columns per value, each refining the residual of the previous
+    scalar_ieee = 3 // 8 columns per value, one per nibble of the IEEE float (column_size >= 16)
+};
+
+// encodes arrays of scalars to CSDRs (and back) natively
+// the encoded CSDR is C-contiguous int32, so Hierarchy.step uses it without another copy
+class Scalar_Encoder {
+private:
+    Scalar_Encoding encoding;
+
+    int num_values;
+    int column_size;
+    int num_columns;
+
+    float low;
+    float high;
+    float sensitivity;
+    int num_scales;
+    float scale_factor;
+
+public:
+    Scalar_Encoder(
+        int num_values,
+        int column_size,
+        Scalar_Encoding encoding,
+        float low,
+        float high,
+        float sensitivity,
+        int num_scales,
+        float scale_factor,
+        int num_columns
+    );
+
+    // values is (num_values,), returns (num_columns,) with unused columns set to 0
+    py::array_t<int> encode(
+        const py::array_t<float, py::array::c_style | py::array::forcecast> &values,
+        const py::object &out
+    ) const;
+
+    // cis is at least (num_values * columns per value,), returns (num_values,)
+    py::array_t<float> decode(
+        const py::array_t<int, py::array::c_style | py::array::forcecast> &cis
+    ) const;
+
+    int get_columns_per_value() const;
+
+    int get_num_values() const {
+        return num_values;
+    }
+
+    int get_column_size() const {
+        return column_size;
+    }
+
+    int get_num_columns() const {
+        return num_columns;
+    }
+
+    Scalar_Encoding get_encoding() const {
+        return encoding;
+    }
+};
+}